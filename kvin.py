@@ -19,12 +19,30 @@ from __future__ import absolute_import, division, print_function
 
 import functools
 import json
+import numbers
 import operator
 import re
 import sys
 
+try:
+    import rekvin       # The native parser: `make python`, then add ./bin to PYTHONPATH.
+except ImportError:
+    rekvin  = None
+
 axisre  = re.compile(r'([0-9]+)|([a-zA-Z_][a-zA-Z_0-9]*)')
-valuere = re.compile(r'(?P<num>[0-9]+)|(?P<cid>[a-zA-Z_][a-zA-Z_0-9]*)|("(?P<str>[^"]*)")|(`(?P<sym>[a-zA-Z_][a-zA-Z0-9_]*))')
+valuere = re.compile(r'(?P<num>-?[0-9]+)|(?P<cid>[a-zA-Z_][a-zA-Z_0-9]*)|("(?P<str>(\\.|[^"\\])*)")|(`(?P<sym>[a-zA-Z_][a-zA-Z0-9_]*))')
+escapere = re.compile(br'\\(x[0-9a-fA-F]{1,2}|.)', re.S)
+escapes = { b'n': b'\n', b't': b'\t', b'r': b'\r', b'0': b'\0', b'x': b'\0' }
+
+# Decodes a byte-string's escapes as rekvin.h's kvinUnescape does.
+def Unescape(text):
+    def unescape(m):
+        esc = m.group(1)
+        if len(esc) > 1:
+            return bytes([int(esc[1:], 16)])
+        return escapes.get(esc, esc)
+    raw = escapere.sub(unescape, text.encode('utf-8', 'surrogateescape'))
+    return raw.decode('utf-8', 'surrogateescape')
 
 def JoinPath(old, new):
     if old is None:
@@ -33,7 +51,7 @@ def JoinPath(old, new):
         old     = [ ]
     combined    = old + new
     npath       = [ ]
-    for ndx in xrange(len(combined)):
+    for ndx in range(len(combined)):
         if combined[ndx] is None:
             if len(npath) > 0:
                 npath.pop(-1)
@@ -45,18 +63,23 @@ def SetValueInPath(tree, path, value, parent=None):
     if len(path) > 0:
         if type(tree) is not dict:
             tree                = { }
-        if not tree.has_key(path[0]):
+        if path[0] not in tree:
             tree[path[0]]       = { }
         SetValueInPath(tree[path[0]], path[1:], value, (path[0],tree))
     else:
         parent[1][parent[0]]    = value
 
+# Small integer-keyed dicts always become lists; larger ones only if at least
+# half the slots are used, so a[9223372036854775807] stays a dict.
+def IsDense(keys):
+    return (max(keys) < 1024) or (max(keys) // 2 < len(keys))
+
 def InferArrays(tree):
     if type(tree) is not dict:
         return tree
-    keys                = tree.keys()
-    if functools.reduce(operator.and_, [type(key) is int or type(key) is long for key in keys]):
-        array           = [None for x in xrange(max(keys)+1)]
+    keys                = list(tree.keys())
+    if functools.reduce(operator.and_, [isinstance(key, numbers.Integral) for key in keys]) and IsDense(keys):
+        array           = [None for x in range(max(keys)+1)]
         for key in keys:
             array[key]  = tree[key]
         tree            = array
@@ -64,38 +87,46 @@ def InferArrays(tree):
         tree[key]       = InferArrays(tree[key])
     return tree
 
-lastPath                = None
-root                    = { }
-with open(sys.argv[1]) as kvinfp:
-    for line in kvinfp.readlines():
-        if line.startswith('#'):
-            continue
-        lhs,rhs         = [x.strip() for x in line.split('=')]
-        m               = valuere.match(rhs)
-        assert m is not None
-        g               = m.groupdict()
-        if g['num'] is not None:
-            rhs         = int(g['num'])
-        elif g['cid'] is not None:
-            pass
-        elif g['sym'] is not None:
-            pass
-        elif g['str'] is not None:
-            rhs         = rhs.strip('"')
-        lhs             = lhs.replace('[', '.')
-        lhs             = lhs.replace(']', '')
-        path            = lhs.split('.')
-        for ndx in xrange(len(path)):
-            if len(path[ndx]) == 0:
-                path[ndx]   = None
+def ParseKVIN(path):
+    lastPath                = None
+    root                    = { }
+    with open(path) as kvinfp:
+        for line in kvinfp.readlines():
+            if line.startswith('#'):
                 continue
-            m               = axisre.match(path[ndx])
-            if m.group(1):
-                path[ndx]   = int(path[ndx])
-        path            = JoinPath(lastPath, path)
-        SetValueInPath(root, path, rhs)
-        lastPath        = path
+            lhs,rhs         = [x.strip() for x in line.split('=', 1)]
+            m               = valuere.match(rhs)
+            assert m is not None
+            g               = m.groupdict()
+            if g['num'] is not None:
+                rhs         = int(g['num'])
+            elif g['cid'] is not None:
+                pass
+            elif g['sym'] is not None:
+                pass
+            elif g['str'] is not None:
+                rhs         = Unescape(g['str'])
+            lhs             = lhs.replace('[', '.')
+            lhs             = lhs.replace(']', '')
+            path            = lhs.split('.')
+            for ndx in range(len(path)):
+                if len(path[ndx]) == 0:
+                    path[ndx]   = None
+                    continue
+                m               = axisre.match(path[ndx])
+                if m.group(1):
+                    path[ndx]   = int(path[ndx])
+            path            = JoinPath(lastPath, path)
+            SetValueInPath(root, path, rhs)
+            lastPath        = path
+    return InferArrays(root)
 
-root                    = InferArrays(root)
+def LoadKVIN(path):
+    if rekvin is None:
+        return ParseKVIN(path)
+    with open(path, 'rb') as kvinfp:
+        return rekvin.loads(kvinfp.read())
 
-print(json.dumps(root, indent=2))
\ No newline at end of file
+if __name__ == '__main__':
+    root                = LoadKVIN(sys.argv[1])
+    print(json.dumps(root, indent=2))
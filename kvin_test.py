@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+#
+# Checks rekvin.loads and rekvin.iterparse against kvin.py's pure-Python
+# parser. `make python` runs it, with ./bin on PYTHONPATH.
+#
+
+from __future__ import absolute_import, division, print_function
+
+import os
+import sys
+import tempfile
+
+import kvin
+import rekvin
+
+# Only what kvin.py's parser understands: no reals, `#` or `//` comments.
+CASES = [
+    "foo.bar = 10\n   .baz = 12\n",
+    "foo.bar.baz.quux = 10\n      ..feh.quux = 12\n",
+    "a[0] = x\na[1] = y\na[2] = z\n",
+    "s[1] = a\ns[4] = b\n",
+    "n = -1\nm = -9223372036854775808\np = 9223372036854775807\n",
+    "s = \"a\\tb\\\"c\\x41\\\\\"\nt = \"x = y\"\n",
+    "a[9223372036854775807] = 1\n",
+    "a[2000] = 1\na[1] = 2\n",
+    "a[1500] = 1\n" + "".join("a[%d] = %d\n" % (ii, ii) for ii in range(1000)),
+]
+
+def PureKVIN(text):
+    fd, path    = tempfile.mkstemp(suffix='.kvin')
+    try:
+        with os.fdopen(fd, 'w') as kvinfp:
+            kvinfp.write(text)
+        return kvin.ParseKVIN(path)
+    finally:
+        os.remove(path)
+
+def IterKVIN(text):
+    root        = { }
+    for path, value in rekvin.iterparse(text):
+        kvin.SetValueInPath(root, list(path), value)
+    return kvin.InferArrays(root)
+
+def main():
+    failed      = 0
+    for text in CASES:
+        expected    = PureKVIN(text)
+        for name, parse in (('loads', rekvin.loads), ('iterparse', IterKVIN)):
+            actual  = parse(text)
+            passed  = (actual == expected) and (parse(text.encode('utf-8')) == expected)
+            failed += not passed
+            print("    %r\n    %s %s" % (text[:40], name, "passed" if passed else "failed"))
+            if not passed:
+                print("        expected %r\n        actual   %r" % (expected, actual))
+    try:
+        rekvin.loads("a = 1x\n")
+        failed += 1
+        print("    malformed failed")
+    except ValueError:
+        print("    malformed passed")
+    print("python %s: %d failed" % ("FAILED" if failed else "passed", failed))
+    return not not failed
+
+if __name__ == '__main__':
+    sys.exit(main())
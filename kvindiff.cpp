@@ -0,0 +1,946 @@
+#include "rekvin.h"
+#include "kvintool.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Structural diff of two KVIN documents.
+//
+// Each input is resolved to absolute paths as it is parsed, and every
+// assignment becomes a record: the path, encoded so that memcmp orders it as
+// kvinCompareAxis does (and a path before everything under it), then the
+// assignment's sequence number and its value. Records are sorted in runs of
+// bounded size; runs that do not fit are written one after another to a
+// temporary file, and merged KVIN_DIFF_FAN_IN at a time, in as many passes
+// as it takes to leave that many. The sorted stream is then reduced to what a KVINDoc would hold,
+// and the two reduced streams are merged, reporting
+//
+//      - path = value              only in the old document
+//      + path = value              only in the new document
+//      ~ path = old -> new         in both, with different values
+//
+// Numbers are compared by value, identifiers and byte-strings by their text.
+
+enum
+{
+    KVIN_DIFF_MAX_DEPTH     = 4096,
+    KVIN_DIFF_FAN_IN        = 16,
+    KVIN_DIFF_BLOCK         = 1 << 16,      // Read from a run at a time.
+};
+
+// Path encoding: an integer axis is 0x01 and 8 bytes big-endian, an
+// identifier is 0x02, its bytes, and 0x00 (which identifiers cannot hold).
+enum
+{
+    KVIN_DIFF_INTEGER       = 0x01,
+    KVIN_DIFF_IDENTIFIER    = 0x02,
+};
+
+// A record, as laid out in memory and in run files; all fields unaligned.
+//
+//      u32 size, u32 keyLen, key, u64 seq, u8 type, u64 integer,
+//      long double real, text (the value as written)
+typedef struct DRecord
+{
+    const unsigned char    *key;
+    size_t                  keyLen;
+    unsigned long long      seq;
+    KVIN_VALUE              type;
+    unsigned long long      integer;
+    long double             real;
+    const char             *text;
+    size_t                  textLen;
+} DRecord;
+
+static void kvinDiffError(const char* name, const char* fst, const char* at, const char* msg)
+{
+    int lineNo  = 0;
+    int column  = 0;
+    kvinLocate(fst, at, &lineNo, &column);
+    fprintf(stderr, "%s:%d:%d: error: %s\n", name, lineNo, column, msg);
+}
+
+static const size_t KVIN_DIFF_FIXED = 4 + 4 + 8 + 1 + 8 + sizeof(long double);
+
+static unsigned diffGet32(const unsigned char* at)
+{
+    unsigned    u32 = 0;
+    memcpy(&u32, at, 4);
+    return u32;
+}
+
+static void diffDecode(const unsigned char* rec, DRecord* out)
+{
+    size_t      keyLen  = diffGet32(rec + 4);
+    const unsigned char*    at  = rec + 8 + keyLen;
+    out->key            = rec + 8;
+    out->keyLen         = keyLen;
+    memcpy(&out->seq, at, 8);
+    out->type           = (KVIN_VALUE)at[8];
+    memcpy(&out->integer, at + 9, 8);
+    memcpy(&out->real, at + 17, sizeof(long double));
+    out->text           = (const char*)(at + 17 + sizeof(long double));
+    out->textLen        = diffGet32(rec) - KVIN_DIFF_FIXED - keyLen;
+}
+
+static int diffCompareKeys(const unsigned char* lkey, size_t llen, const unsigned char* rkey, size_t rlen)
+{
+    int         cmp     = memcmp(lkey, rkey, (llen < rlen) ? llen : rlen);
+    if (cmp)
+    {
+        return cmp;
+    }
+    return (llen < rlen) ? -1 : (llen > rlen);
+}
+
+// Orders by path, then by sequence number.
+static int diffCompareRecords(const unsigned char* lhs, const unsigned char* rhs)
+{
+    size_t      llen    = diffGet32(lhs + 4);
+    size_t      rlen    = diffGet32(rhs + 4);
+    int         cmp     = diffCompareKeys(lhs + 8, llen, rhs + 8, rlen);
+    if (cmp)
+    {
+        return cmp;
+    }
+    unsigned long long  lseq    = 0;
+    unsigned long long  rseq    = 0;
+    memcpy(&lseq, lhs + 8 + llen, 8);
+    memcpy(&rseq, rhs + 8 + rlen, 8);
+    return (lseq < rseq) ? -1 : (lseq > rseq);
+}
+
+static const unsigned char* sSortArena  = 0;
+
+static int diffCompareIndex(const void* lhs, const void* rhs)
+{
+    return diffCompareRecords(sSortArena + *(const size_t*)lhs, sSortArena + *(const size_t*)rhs);
+}
+
+// A sorted run: where it lies in its side's spill file.
+typedef struct DSpan
+{
+    long                beg;
+    long                end;
+} DSpan;
+
+// A run being merged, read back a block at a time.
+typedef struct DRun
+{
+    long                pos;        // Of the next block.
+    long                end;
+    unsigned char      *block;
+    size_t              at;
+    size_t              len;
+    unsigned char      *rec;
+    size_t              cap;
+} DRun;
+
+// Merges up to KVIN_DIFF_FAN_IN runs of fp: heap holds the runs that have a
+// record, least first. The least record was handed out if taken is set, and
+// its run moves on at the next call.
+typedef struct DMerge
+{
+    FILE               *fp;
+    DRun                runs[KVIN_DIFF_FAN_IN];
+    int                 heap[KVIN_DIFF_FAN_IN];
+    int                 size;
+    int                 taken;
+} DMerge;
+
+typedef struct DiffSide
+{
+    const char         *name;
+    unsigned char      *arena;
+    size_t              used;
+    size_t              capArena;
+    size_t              budget;     // For the arena and the index together.
+    size_t             *index;
+    size_t              numRecs;
+    size_t              capRecs;
+    size_t              next;       // Into index, once sorted in memory.
+    FILE               *spill;      // The sorted runs, one after another.
+    DSpan              *spans;
+    size_t              numRuns;
+    size_t              capRuns;
+    DMerge              merge;      // Of the last runs, once few enough are left.
+    unsigned long long  seq;
+} DiffSide;
+
+static int diffSpill(DiffSide* side)
+{
+    sSortArena          = side->arena;
+    qsort(side->index, side->numRecs, sizeof(size_t), diffCompareIndex);
+    if (!side->spill && !(side->spill = tmpfile()))
+    {
+        fprintf(stderr, "%s: cannot create a temporary file\n", side->name);
+        return 0;
+    }
+    if (side->numRuns == side->capRuns)
+    {
+        size_t      cap     = side->capRuns ? (2 * side->capRuns) : 64;
+        DSpan*      spans   = (DSpan*)realloc(side->spans, cap * sizeof(DSpan));
+        if (!spans)
+        {
+            fprintf(stderr, "%s: out of memory\n", side->name);
+            return 0;
+        }
+        side->spans         = spans;
+        side->capRuns       = cap;
+    }
+    DSpan*          span    = &side->spans[side->numRuns];
+    span->beg               = ftell(side->spill);
+    for (size_t RR = 0; RR < side->numRecs; ++RR)
+    {
+        const unsigned char*    rec = side->arena + side->index[RR];
+        if (fwrite(rec, 1, diffGet32(rec), side->spill) != diffGet32(rec))
+        {
+            fprintf(stderr, "%s: cannot write a temporary file\n", side->name);
+            return 0;
+        }
+    }
+    span->end               = ftell(side->spill);
+    ++side->numRuns;
+    side->used          = 0;
+    side->numRecs       = 0;
+    return 1;
+}
+
+// Copies the next n bytes of a run to dst; 0 if they cannot be read.
+static int diffRunFetch(FILE* fp, DRun* run, unsigned char* dst, size_t n)
+{
+    while (n)
+    {
+        if (run->at == run->len)
+        {
+            size_t  want    = ((size_t)(run->end - run->pos) < KVIN_DIFF_BLOCK) ? (size_t)(run->end - run->pos) : KVIN_DIFF_BLOCK;
+            if (!want || (fseek(fp, run->pos, SEEK_SET) != 0) || (fread(run->block, 1, want, fp) != want))
+            {
+                return 0;
+            }
+            run->pos       += want;
+            run->at         = 0;
+            run->len        = want;
+        }
+        size_t      part    = (run->len - run->at < n) ? (run->len - run->at) : n;
+        memcpy(dst, run->block + run->at, part);
+        run->at            += part;
+        dst                += part;
+        n                  -= part;
+    }
+    return 1;
+}
+
+// Reads a run's next record into run->rec, or clears *more at its end.
+static int diffRunRead(DiffSide* side, FILE* fp, DRun* run, int* more)
+{
+    unsigned char   head[4];
+    *more                   = (run->at < run->len) || (run->pos < run->end);
+    if (!*more)
+    {
+        return 1;
+    }
+    if (!diffRunFetch(fp, run, head, 4))
+    {
+        fprintf(stderr, "%s: cannot read a temporary file\n", side->name);
+        return 0;
+    }
+    size_t          size    = diffGet32(head);
+    if (size > run->cap)
+    {
+        unsigned char*  rec = (unsigned char*)realloc(run->rec, size);
+        if (!rec)
+        {
+            fprintf(stderr, "%s: out of memory\n", side->name);
+            return 0;
+        }
+        run->rec            = rec;
+        run->cap            = size;
+    }
+    memcpy(run->rec, head, 4);
+    if (!diffRunFetch(fp, run, run->rec + 4, size - 4))
+    {
+        fprintf(stderr, "%s: cannot read a temporary file\n", side->name);
+        return 0;
+    }
+    return 1;
+}
+
+static void diffSiftDown(DMerge* merge, int at)
+{
+    for (;;)
+    {
+        int         least   = at;
+        for (int KK = 2 * at + 1; (KK <= 2 * at + 2) && (KK < merge->size); ++KK)
+        {
+            if (diffCompareRecords(merge->runs[merge->heap[KK]].rec, merge->runs[merge->heap[least]].rec) < 0)
+            {
+                least       = KK;
+            }
+        }
+        if (least == at)
+        {
+            return;
+        }
+        int         swap    = merge->heap[at];
+        merge->heap[at]     = merge->heap[least];
+        merge->heap[least]  = swap;
+        at                  = least;
+    }
+}
+
+// Starts merging count (at most KVIN_DIFF_FAN_IN) runs of fp.
+static int diffMergeInit(DiffSide* side, DMerge* merge, FILE* fp, const DSpan* spans, size_t count)
+{
+    merge->fp               = fp;
+    merge->size             = 0;
+    merge->taken            = 0;
+    for (int RR = 0; RR < (int)count; ++RR)
+    {
+        DRun*       run     = &merge->runs[RR];
+        int         more    = 0;
+        if (!run->block && !(run->block = (unsigned char*)malloc(KVIN_DIFF_BLOCK)))
+        {
+            fprintf(stderr, "%s: out of memory\n", side->name);
+            return 0;
+        }
+        run->pos            = spans[RR].beg;
+        run->end            = spans[RR].end;
+        run->at             = 0;
+        run->len            = 0;
+        if (!diffRunRead(side, fp, run, &more))
+        {
+            return 0;
+        }
+        if (more)
+        {
+            merge->heap[merge->size++]  = RR;
+        }
+    }
+    for (int at = merge->size / 2 - 1; at >= 0; --at)
+    {
+        diffSiftDown(merge, at);
+    }
+    return 1;
+}
+
+// The least record left in the merge, valid until the next call.
+static const unsigned char* diffMergeNext(DiffSide* side, DMerge* merge, int* ok)
+{
+    if (merge->taken)
+    {
+        int         more    = 0;
+        if (!diffRunRead(side, merge->fp, &merge->runs[merge->heap[0]], &more))
+        {
+            *ok             = 0;
+            return 0;
+        }
+        if (!more)
+        {
+            merge->heap[0]  = merge->heap[--merge->size];
+        }
+        diffSiftDown(merge, 0);
+    }
+    merge->taken            = (merge->size > 0);
+    return merge->size ? merge->runs[merge->heap[0]].rec : 0;
+}
+
+// Merges the runs KVIN_DIFF_FAN_IN at a time into a new spill file, until
+// no more than that are left, and starts merging those.
+static int diffMergeRuns(DiffSide* side)
+{
+    int             ok      = 1;
+    while (ok && (side->numRuns > KVIN_DIFF_FAN_IN))
+    {
+        FILE*       into    = tmpfile();
+        size_t      merged  = 0;
+        if (!into)
+        {
+            fprintf(stderr, "%s: cannot create a temporary file\n", side->name);
+            return 0;
+        }
+        for (size_t RR = 0; ok && (RR < side->numRuns); RR += KVIN_DIFF_FAN_IN)
+        {
+            size_t  count   = (side->numRuns - RR < KVIN_DIFF_FAN_IN) ? (side->numRuns - RR) : KVIN_DIFF_FAN_IN;
+            DSpan   span    = { ftell(into), 0 };
+            ok              = diffMergeInit(side, &side->merge, side->spill, side->spans + RR, count);
+            for (const unsigned char* rec = 0; ok && (rec = diffMergeNext(side, &side->merge, &ok)); )
+            {
+                if (fwrite(rec, 1, diffGet32(rec), into) != diffGet32(rec))
+                {
+                    fprintf(stderr, "%s: cannot write a temporary file\n", side->name);
+                    ok      = 0;
+                }
+            }
+            // The spans from RR on were read by diffMergeInit.
+            span.end        = ftell(into);
+            side->spans[merged++]   = span;
+        }
+        fclose(side->spill);
+        side->spill         = into;
+        side->numRuns       = merged;
+    }
+    return ok && diffMergeInit(side, &side->merge, side->spill, side->spans, side->numRuns);
+}
+
+static int diffAdd(DiffSide* side, const unsigned char* key, size_t keyLen, const KVINParser* prs)
+{
+    const char*     text    = prs->lexer.lbeg;
+    size_t          textLen = prs->lexer.lend - prs->lexer.lbeg;
+    size_t          size    = KVIN_DIFF_FIXED + keyLen + textLen;
+    if ((size > 0xFFFFFFFFu) || (size + sizeof(size_t) > side->budget))
+    {
+        fprintf(stderr, "%s: an assignment is larger than the memory budget\n", side->name);
+        return 0;
+    }
+    if (side->used + size + (side->numRecs + 1) * sizeof(size_t) > side->budget)
+    {
+        if (!diffSpill(side))
+        {
+            return 0;
+        }
+    }
+    if (side->numRecs == side->capRecs)
+    {
+        size_t      cap     = side->capRecs ? (2 * side->capRecs) : 1024;
+        size_t*     index   = (size_t*)realloc(side->index, cap * sizeof(size_t));
+        if (!index)
+        {
+            fprintf(stderr, "%s: out of memory\n", side->name);
+            return 0;
+        }
+        side->index         = index;
+        side->capRecs       = cap;
+    }
+
+    if (side->used + size > side->capArena)
+    {
+        size_t          cap     = 2 * (side->used + size);
+        cap                     = (cap < side->budget) ? cap : side->budget;
+        unsigned char*  arena   = (unsigned char*)realloc(side->arena, cap);
+        if (!arena)
+        {
+            fprintf(stderr, "%s: out of memory\n", side->name);
+            return 0;
+        }
+        side->arena             = arena;
+        side->capArena          = cap;
+    }
+
+    unsigned char*  rec     = side->arena + side->used;
+    unsigned        u32     = (unsigned)size;
+    unsigned char   type    = (unsigned char)prs->value.type;
+    unsigned long long  integer = (prs->value.type == KVIN_VAL_INTEGER) ? prs->value.integer : 0;
+    long double     real    = (prs->value.type == KVIN_VAL_REAL) ? prs->value.real : 0;
+    memcpy(rec, &u32, 4);
+    u32                     = (unsigned)keyLen;
+    memcpy(rec + 4, &u32, 4);
+    memcpy(rec + 8, key, keyLen);
+    rec                    += 8 + keyLen;
+    memcpy(rec, &side->seq, 8);
+    rec[8]                  = type;
+    memcpy(rec + 9, &integer, 8);
+    memcpy(rec + 17, &real, sizeof(long double));
+    memcpy(rec + 17 + sizeof(long double), text, textLen);
+
+    side->index[side->numRecs++]    = side->used;
+    side->used             += size;
+    ++side->seq;
+    return 1;
+}
+
+static size_t diffEncodeAxis(const KVINValue* axis, unsigned char* out)
+{
+    if (axis->type == KVIN_VAL_INTEGER)
+    {
+        out[0]              = KVIN_DIFF_INTEGER;
+        for (int BB = 0; BB < 8; ++BB)
+        {
+            out[1 + BB]     = (unsigned char)(axis->integer >> (56 - 8 * BB));
+        }
+        return 9;
+    }
+    size_t          len     = axis->end - axis->begin;
+    out[0]                  = KVIN_DIFF_IDENTIFIER;
+    memcpy(out + 1, axis->begin, len);
+    out[1 + len]            = 0;
+    return len + 2;
+}
+
+// Parses a whole input into sorted records. The encoded path is kept up to
+// date axis by axis, so each assignment costs the axes it changes.
+static int diffLoad(DiffSide* side, const char* fst, const char* lst)
+{
+    static KVINValue    axes[KVIN_DIFF_MAX_DEPTH];
+    static size_t       keyEnd[KVIN_DIFF_MAX_DEPTH + 1];
+    unsigned char      *key     = 0;
+    size_t              keyCap  = 0;
+    int                 encoded = 0;    // Axes of path already in key.
+    KVINParser          prs     = { };
+    KVINPath            path    = { };
+    int                 more    = 0;
+    int                 ok      = 1;
+
+    kvinInitPath(&path, axes, KVIN_DIFF_MAX_DEPTH);
+    if ((fst >= lst) || !kvinInitParser(&prs, fst, lst))
+    {
+        return 1;
+    }
+    keyEnd[0]               = 0;
+    do
+    {
+        more                = kvinParseNext(&prs);
+        if (!kvinPathApply(&path, &prs))
+        {
+            kvinDiffError(side->name, fst, prs.lexer.lbeg, "path is too deep");
+            ok              = 0;
+            break;
+        }
+        switch (prs.action)
+        {
+        case KVIN_ACT_SETATROOT     : encoded = 0; break;
+        case KVIN_ACT_RELPATH       : encoded = (encoded < path.depth) ? encoded : path.depth; break;
+        case KVIN_ACT_SETVALUE      :
+            for (; encoded < path.depth; ++encoded)
+            {
+                const KVINValue*    axis    = &path.axes[encoded];
+                size_t              need    = keyEnd[encoded] + 2 + ((axis->type == KVIN_VAL_INTEGER) ? 8 : (axis->end - axis->begin));
+                if (need > keyCap)
+                {
+                    unsigned char*  grown   = (unsigned char*)realloc(key, 2 * need);
+                    if (!grown)
+                    {
+                        fprintf(stderr, "%s: out of memory\n", side->name);
+                        free(key);
+                        return 0;
+                    }
+                    key             = grown;
+                    keyCap          = 2 * need;
+                }
+                keyEnd[encoded + 1] = keyEnd[encoded] + diffEncodeAxis(axis, key + keyEnd[encoded]);
+            }
+            ok              = (path.depth == 0) || diffAdd(side, key, keyEnd[path.depth], &prs);
+            // The next assignment may set another value on the same path.
+            encoded         = path.depth;
+            break;
+        default                     : break;
+        }
+    } while (more && ok);
+    free(key);
+
+    if (ok && (prs.state != KVIN_PAR_DONE))
+    {
+        kvinDiffError(side->name, fst, (prs.lexer.lbeg < lst) ? prs.lexer.lbeg : lst, "malformed KVIN");
+        ok                  = 0;
+    }
+    if (ok && side->numRuns && side->numRecs)
+    {
+        ok                  = diffSpill(side);
+    }
+    if (ok && side->numRuns)
+    {
+        ok                  = diffMergeRuns(side);
+    }
+    if (ok && !side->numRuns)
+    {
+        sSortArena          = side->arena;
+        qsort(side->index, side->numRecs, sizeof(size_t), diffCompareIndex);
+    }
+    return ok;
+}
+
+// The next record in sorted order: from memory, or from the merge of the
+// runs. The record stays valid until the next call.
+static const unsigned char* diffNextRecord(DiffSide* side, int* ok)
+{
+    static const unsigned char* const   NONE    = 0;
+    if (!side->numRuns)
+    {
+        return (side->next < side->numRecs) ? (side->arena + side->index[side->next++]) : NONE;
+    }
+    return diffMergeNext(side, &side->merge, ok);
+}
+
+// A resolved entry: a path and the value a KVINDoc would end up with there.
+typedef struct DEntry
+{
+    unsigned char      *rec;
+    size_t              cap;
+    int                 valid;
+} DEntry;
+
+static int diffKeep(DiffSide* side, DEntry* entry, const unsigned char* rec)
+{
+    size_t          size    = diffGet32(rec);
+    if (size > entry->cap)
+    {
+        unsigned char*  grown   = (unsigned char*)realloc(entry->rec, size);
+        if (!grown)
+        {
+            fprintf(stderr, "%s: out of memory\n", side->name);
+            return 0;
+        }
+        entry->rec          = grown;
+        entry->cap          = size;
+    }
+    memcpy(entry->rec, rec, size);
+    entry->valid            = 1;
+    return 1;
+}
+
+// Reduces the sorted records to what a KVINDoc holds. Assigning a path
+// replaces everything assigned under it before, and assigning under a path
+// replaces its value, so an assignment survives if it is the last to its
+// path, and nothing above or below it was assigned later. Sorted, a path's
+// records precede everything under it, so a stack of the current path's
+// axes suffices: frame DD holds the last assignment to the first DD + 1
+// axes, the latest assignment above it, and the latest below it so far. A
+// frame's assignment is decided when it is popped; of the frames popped at
+// once, at most one can survive.
+typedef struct DFrame
+{
+    size_t              keyEnd;
+    long long           seq;        // Of this path's last assignment, or -1.
+    long long           above;
+    long long           below;
+    DEntry              entry;
+} DFrame;
+
+typedef struct DResolver
+{
+    DiffSide           *side;
+    DFrame             *frames;
+    int                 depth;
+    unsigned char      *key;        // The path of the deepest frame.
+    size_t              keyCap;
+    DEntry              ahead;      // The next record, read to find a path's last.
+    int                 started;
+} DResolver;
+
+static size_t diffAxisEnd(const unsigned char* key, size_t at)
+{
+    if (key[at] == KVIN_DIFF_INTEGER)
+    {
+        return at + 9;
+    }
+    for (++at; key[at]; ++at)
+    {
+    }
+    return at + 1;
+}
+
+static int diffPop(DResolver* res, int depth, DEntry* out)
+{
+    while (res->depth > depth)
+    {
+        DFrame*     frame   = &res->frames[--res->depth];
+        if ((frame->seq >= 0) && (frame->seq > frame->above) && (frame->seq > frame->below))
+        {
+            DEntry  swap    = *out;
+            *out            = frame->entry;
+            frame->entry    = swap;
+            out->valid      = 1;
+        }
+        if (res->depth > 0)
+        {
+            DFrame* parent  = &res->frames[res->depth - 1];
+            long long later = (frame->seq > frame->below) ? frame->seq : frame->below;
+            parent->below   = (later > parent->below) ? later : parent->below;
+        }
+    }
+    return 1;
+}
+
+// The next surviving entry into out, or out->valid = 0 at the end.
+static int diffResolveNext(DResolver* res, DEntry* out)
+{
+    int             ok      = 1;
+    out->valid              = 0;
+    if (!res->started)
+    {
+        const unsigned char*    rec = diffNextRecord(res->side, &ok);
+        res->started        = 1;
+        res->ahead.valid    = 0;
+        if (rec && !diffKeep(res->side, &res->ahead, rec))
+        {
+            return 0;
+        }
+    }
+    while (!out->valid && res->ahead.valid)
+    {
+        // Take the record ahead, and skip to the last of its path.
+        DEntry      cur     = res->ahead;
+        DRecord     curRec  = { };
+        DRecord     nextRec = { };
+        const unsigned char*    rec = 0;
+        res->ahead.rec      = 0;
+        res->ahead.cap      = 0;
+        res->ahead.valid    = 0;
+        for (;;)
+        {
+            diffDecode(cur.rec, &curRec);
+            if (!(rec = diffNextRecord(res->side, &ok)))
+            {
+                break;
+            }
+            diffDecode(rec, &nextRec);
+            if (diffCompareKeys(curRec.key, curRec.keyLen, nextRec.key, nextRec.keyLen) != 0)
+            {
+                break;
+            }
+            if (!diffKeep(res->side, &cur, rec))
+            {
+                free(cur.rec);
+                return 0;
+            }
+        }
+        if (!ok || (rec && !diffKeep(res->side, &res->ahead, rec)))
+        {
+            free(cur.rec);
+            return 0;
+        }
+
+        // Pop the frames this path does not share, then push the rest.
+        int         common  = 0;
+        size_t      at      = 0;
+        for (; common < res->depth; ++common)
+        {
+            size_t  end     = res->frames[common].keyEnd;
+            if ((end > curRec.keyLen) || (memcmp(res->key + at, curRec.key + at, end - at) != 0))
+            {
+                break;
+            }
+            at              = end;
+        }
+        diffPop(res, common, out);
+        if (curRec.keyLen > res->keyCap)
+        {
+            unsigned char*  grown   = (unsigned char*)realloc(res->key, 2 * curRec.keyLen);
+            if (!grown)
+            {
+                fprintf(stderr, "%s: out of memory\n", res->side->name);
+                free(cur.rec);
+                return 0;
+            }
+            res->key        = grown;
+            res->keyCap     = 2 * curRec.keyLen;
+        }
+        memcpy(res->key + at, curRec.key + at, curRec.keyLen - at);
+        for (; at < curRec.keyLen; ++res->depth)
+        {
+            if (res->depth == KVIN_DIFF_MAX_DEPTH)
+            {
+                fprintf(stderr, "%s: path is too deep\n", res->side->name);
+                free(cur.rec);
+                return 0;
+            }
+            DFrame* frame   = &res->frames[res->depth];
+            DFrame* parent  = res->depth ? &res->frames[res->depth - 1] : 0;
+            at              = diffAxisEnd(curRec.key, at);
+            frame->keyEnd   = at;
+            frame->seq      = -1;
+            frame->above    = parent ? ((parent->seq > parent->above) ? parent->seq : parent->above) : -1;
+            frame->below    = -1;
+        }
+        DFrame*     leaf    = &res->frames[res->depth - 1];
+        leaf->seq           = (long long)curRec.seq;
+        free(leaf->entry.rec);
+        leaf->entry         = cur;
+    }
+    if (!out->valid && !res->ahead.valid)
+    {
+        diffPop(res, 0, out);
+    }
+    return 1;
+}
+
+static void diffPutPath(KVINOut* out, const unsigned char* key, size_t keyLen)
+{
+    for (size_t at = 0; at < keyLen; at = diffAxisEnd(key, at))
+    {
+        if (key[at] == KVIN_DIFF_INTEGER)
+        {
+            unsigned long long  index   = 0;
+            for (int BB = 0; BB < 8; ++BB)
+            {
+                index       = (index << 8) | key[at + 1 + BB];
+            }
+            kvinOutChar(out, '[');
+            kvinOutUnsigned(out, index);
+            kvinOutChar(out, ']');
+            continue;
+        }
+        if (at)
+        {
+            kvinOutChar(out, '.');
+        }
+        kvinOutPut(out, (const char*)key + at + 1, diffAxisEnd(key, at) - at - 2);
+    }
+}
+
+static int diffSameValue(const DRecord* lhs, const DRecord* rhs)
+{
+    if (lhs->type != rhs->type)
+    {
+        return 0;
+    }
+    switch (lhs->type)
+    {
+    case KVIN_VAL_INTEGER   : return lhs->integer == rhs->integer;
+    case KVIN_VAL_REAL      : return (lhs->real == rhs->real) || (isnan(lhs->real) && isnan(rhs->real));
+    default                 : return (lhs->textLen == rhs->textLen) && !memcmp(lhs->text, rhs->text, lhs->textLen);
+    }
+}
+
+static void diffPutEntry(KVINOut* out, char op, const DRecord* rec, const DRecord* now)
+{
+    kvinOutChar(out, op);
+    kvinOutChar(out, ' ');
+    diffPutPath(out, rec->key, rec->keyLen);
+    kvinOutPut(out, " = ", 3);
+    kvinOutPut(out, rec->text, rec->textLen);
+    if (now)
+    {
+        kvinOutPut(out, " -> ", 4);
+        kvinOutPut(out, now->text, now->textLen);
+    }
+    kvinOutChar(out, '\n');
+}
+
+static void diffFreeSide(DiffSide* side)
+{
+    if (side->spill)
+    {
+        fclose(side->spill);
+    }
+    for (int RR = 0; RR < KVIN_DIFF_FAN_IN; ++RR)
+    {
+        free(side->merge.runs[RR].block);
+        free(side->merge.runs[RR].rec);
+    }
+    free(side->spans);
+    free(side->arena);
+    free(side->index);
+}
+
+// Writes the differences from the old document to the new one to out, and
+// returns how many there are, or -1 after reporting an error. Each input may
+// use budget bytes for sorting before it spills to temporary files.
+int kvinDiff(const char* oldName, const char* oldFst, const char* oldLst,
+             const char* newName, const char* newFst, const char* newLst, size_t budget, KVINOut* out)
+{
+    static DiffSide     sides[2];
+    static DFrame       frames[2][KVIN_DIFF_MAX_DEPTH];
+    DResolver           res[2]      = { };
+    DEntry              entries[2]  = { };
+    long long           numDiffs    = 0;
+    int                 ok          = 1;
+
+    memset(sides, 0, sizeof(sides));
+    memset(frames, 0, sizeof(frames));
+    sides[0].name               = oldName;
+    sides[1].name               = newName;
+    for (int SS = 0; SS < 2; ++SS)
+    {
+        sides[SS].budget        = budget;
+        res[SS].side            = &sides[SS];
+        res[SS].frames          = frames[SS];
+    }
+    ok                          = diffLoad(&sides[0], oldFst, oldLst)
+                               && diffLoad(&sides[1], newFst, newLst)
+                               && diffResolveNext(&res[0], &entries[0])
+                               && diffResolveNext(&res[1], &entries[1]);
+
+    while (ok && (entries[0].valid || entries[1].valid))
+    {
+        DRecord         lhs         = { };
+        DRecord         rhs         = { };
+        int             cmp         = !entries[0].valid ? 1 : (!entries[1].valid ? -1 : 0);
+        if (entries[0].valid)
+        {
+            diffDecode(entries[0].rec, &lhs);
+        }
+        if (entries[1].valid)
+        {
+            diffDecode(entries[1].rec, &rhs);
+        }
+        if (entries[0].valid && entries[1].valid)
+        {
+            cmp                 = diffCompareKeys(lhs.key, lhs.keyLen, rhs.key, rhs.keyLen);
+        }
+        if (cmp < 0)
+        {
+            diffPutEntry(out, '-', &lhs, 0);
+        }
+        else
+        if (cmp > 0)
+        {
+            diffPutEntry(out, '+', &rhs, 0);
+        }
+        else
+        if (!diffSameValue(&lhs, &rhs))
+        {
+            diffPutEntry(out, '~', &lhs, &rhs);
+        }
+        numDiffs               += (cmp != 0) || !diffSameValue(&lhs, &rhs);
+        ok                      = ((cmp > 0) || diffResolveNext(&res[0], &entries[0]))
+                               && ((cmp < 0) || diffResolveNext(&res[1], &entries[1]));
+    }
+
+    for (int SS = 0; SS < 2; ++SS)
+    {
+        for (int DD = 0; DD < KVIN_DIFF_MAX_DEPTH; ++DD)
+        {
+            free(frames[SS][DD].entry.rec);
+        }
+        free(res[SS].ahead.rec);
+        free(res[SS].key);
+        free(entries[SS].rec);
+        diffFreeSide(&sides[SS]);
+    }
+    return ok ? ((numDiffs < 0x7FFFFFFF) ? (int)numDiffs : 0x7FFFFFFF) : -1;
+}
+
+int diffMain(int argc, char *argv[])
+{
+    static KVINOut  out             = { };
+    size_t          budgetMB        = 256;
+    char*           data[2]         = { };
+    long            size[2]         = { };
+    int             mapped[2]       = { };
+    int             numDiffs        = -1;
+
+    if ((argc == 4) && (strcmp(argv[0], "-m") == 0) && (atol(argv[1]) > 0))
+    {
+        budgetMB                    = (size_t)atol(argv[1]);
+        argc                       -= 2;
+        argv                       += 2;
+    }
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: kvin diff [-m MB] OLD NEW\n");
+        return 2;
+    }
+    for (int FF = 0; FF < 2; ++FF)
+    {
+        if (!(data[FF] = mapFile(argv[FF], &size[FF], &mapped[FF])))
+        {
+            fprintf(stderr, "%s: cannot read\n", argv[FF]);
+        }
+    }
+    if (data[0] && data[1])
+    {
+        out.fp                      = stdout;
+        numDiffs                    = kvinDiff(argv[0], data[0], data[0] + size[0], argv[1], data[1], data[1] + size[1],
+                                               budgetMB * 1024 * 1024 / 2, &out);
+        kvinOutFlush(&out);
+    }
+    for (int FF = 0; FF < 2; ++FF)
+    {
+        if (data[FF])
+        {
+            unmapFile(data[FF], size[FF], mapped[FF]);
+        }
+    }
+    return (numDiffs < 0) ? 2 : !!numDiffs;
+}
@@ -0,0 +1,1152 @@
+#include "rekvin.h"
+#include "kvintool.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Converts between KVIN and JSON.
+//
+// KVIN to JSON streams when the input is path-sorted: every container's axes
+// strictly increase (integers numerically, before identifiers bytewise), so no
+// container is revisited once it is left and, writing to a regular file,
+// memory is bounded by the path depth; the input is mapped, not read, so it is
+// only paged through. Anything else is loaded into a KVINDoc first, and what
+// was streamed is taken back. Either way, objects whose axes are all integers
+// become arrays, as in kvin.py's InferArrays.
+//
+// JSON to KVIN streams, writing each path relative to the one before it.
+
+enum
+{
+    KVIN_JSON_MAX_DEPTH = 4096,
+};
+
+// Larger integer axes are left as object keys, rather than padded with nulls.
+static const unsigned long long KVIN_JSON_MAX_INDEX = 0xFFFFFFFFull;
+
+// With kvinEscapes, beg to end is a BSTRING's text, decoded by kvinUnescape.
+static void jsonString(KVINOut* out, const char* beg, const char* end, int kvinEscapes)
+{
+    static const char HEX[] = "0123456789abcdef";
+
+    kvinOutChar(out, '"');
+    const char* run         = beg;
+    for (const char* cur = beg; cur < end;)
+    {
+        unsigned char c     = (unsigned char)*cur;
+        if ((c >= 0x20) && (c != '"') && (c != '\\'))
+        {
+            ++cur;
+            continue;
+        }
+        kvinOutPut(out, run, cur - run);
+        if (kvinEscapes)
+        {
+            c               = (unsigned char)kvinUnescape(&cur, end);
+        }
+        else
+        {
+            ++cur;
+        }
+        switch (c)
+        {
+        case '"'    : kvinOutPut(out, "\\\"", 2); break;
+        case '\\'   : kvinOutPut(out, "\\\\", 2); break;
+        case '\n'   : kvinOutPut(out, "\\n", 2); break;
+        case '\t'   : kvinOutPut(out, "\\t", 2); break;
+        case '\r'   : kvinOutPut(out, "\\r", 2); break;
+        case '\b'   : kvinOutPut(out, "\\b", 2); break;
+        case '\f'   : kvinOutPut(out, "\\f", 2); break;
+        default     :
+            if (c < 0x20)
+            {
+                char esc[6] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF] };
+                kvinOutPut(out, esc, sizeof(esc));
+            }
+            else
+            {
+                kvinOutChar(out, (char)c);
+            }
+            break;
+        }
+        run                 = cur;
+    }
+    kvinOutPut(out, run, end - run);
+    kvinOutChar(out, '"');
+}
+
+// The shortest form that reads back as the same double, like Python's repr.
+static void jsonReal(KVINOut* out, long double real)
+{
+    double  dbl     = (double)real;
+    char    buf[40];
+    if (isnan(dbl))
+    {
+        kvinOutPut(out, "NaN", 3);
+        return;
+    }
+    if (isinf(dbl))
+    {
+        kvinOutPut(out, (dbl < 0) ? "-Infinity" : "Infinity", (dbl < 0) ? 9 : 8);
+        return;
+    }
+    for (int prec = 15; prec <= 17; ++prec)
+    {
+        snprintf(buf, sizeof(buf), "%.*g", prec, dbl);
+        if (strtod(buf, 0) == dbl)
+        {
+            break;
+        }
+    }
+    size_t len      = strlen(buf);
+    kvinOutPut(out, buf, len);
+    if (!strpbrk(buf, ".e"))
+    {
+        kvinOutPut(out, ".0", 2);
+    }
+}
+
+// Returns the end of the JSON number starting at beg, or 0 if there is none.
+static const char* jsonNumberEnd(const char* beg, const char* end, int* isReal)
+{
+    const char* cur         = beg + ((beg < end) && (*beg == '-'));
+    const char* digits      = cur;
+    *isReal                 = 0;
+    while ((cur < end) && isdigit((unsigned char)*cur))
+    {
+        ++cur;
+    }
+    if ((cur == digits) || ((digits[0] == '0') && ((cur - digits) > 1)))
+    {
+        return 0;
+    }
+    if ((cur < end) && (*cur == '.'))
+    {
+        const char* frac    = ++cur;
+        while ((cur < end) && isdigit((unsigned char)*cur))
+        {
+            ++cur;
+        }
+        if (cur == frac)
+        {
+            return 0;
+        }
+        *isReal             = 1;
+    }
+    if ((cur < end) && ((*cur | 0x20) == 'e'))
+    {
+        ++cur;
+        if ((cur < end) && ((*cur == '+') || (*cur == '-')))
+        {
+            ++cur;
+        }
+        const char* exp     = cur;
+        while ((cur < end) && isdigit((unsigned char)*cur))
+        {
+            ++cur;
+        }
+        if (cur == exp)
+        {
+            return 0;
+        }
+        *isReal             = 1;
+    }
+    return cur;
+}
+
+// lbeg and lend are the value's lexeme: a real already spelled as a JSON
+// number is copied rather than reformatted.
+static void jsonValue(KVINOut* out, const KVINValue* value, const char* lbeg, const char* lend)
+{
+    int isReal              = 0;
+    switch (value->type)
+    {
+    case KVIN_VAL_IDENTIFIER    : jsonString(out, value->begin, value->end, 0); break;
+    case KVIN_VAL_INTEGER       : kvinOutSigned(out, value->integer); break;
+    case KVIN_VAL_REAL          :
+        if (lbeg && (jsonNumberEnd(lbeg, lend, &isReal) == lend) && isReal)
+        {
+            kvinOutPut(out, lbeg, lend - lbeg);
+        }
+        else
+        {
+            jsonReal(out, value->real);
+        }
+        break;
+    case KVIN_VAL_BSTRING       : jsonString(out, value->begin, value->end, 1); break;
+    default                     : kvinOutPut(out, "null", 4); break;
+    }
+}
+
+static void jsonKey(KVINOut* out, const KVINValue* axis)
+{
+    if (axis->type == KVIN_VAL_INTEGER)
+    {
+        kvinOutChar(out, '"');
+        kvinOutUnsigned(out, axis->integer);
+        kvinOutChar(out, '"');
+    }
+    else
+    {
+        jsonString(out, axis->begin, axis->end, 0);
+    }
+    kvinOutChar(out, ':');
+}
+
+static void jsonNulls(KVINOut* out, unsigned long long count)
+{
+    for (; count; --count)
+    {
+        kvinOutPut(out, "null,", 5);
+    }
+}
+
+static void kvinJsonError(const char* name, const char* fst, const char* at, const char* msg)
+{
+    int lineNo  = 0;
+    int column  = 0;
+    kvinLocate(fst, at, &lineNo, &column);
+    fprintf(stderr, "%s:%d:%d: error: %s\n", name, lineNo, column, msg);
+}
+
+static void kvinJsonParseError(const char* name, const char* fst, const char* lst, const KVINParser* prs)
+{
+    kvinJsonError(name, fst, (prs->lexer.lbeg < lst) ? prs->lexer.lbeg : lst, "malformed KVIN");
+}
+
+typedef enum KVIN_JSON_STREAM
+{
+    KVIN_JSON_STREAMED,
+    KVIN_JSON_UNSORTED,
+    KVIN_JSON_FAILED,
+} KVIN_JSON_STREAM;
+
+// Opens the containers for axes [from, depth) of path, and their entries.
+static void jsonStreamOpen(KVINOut* out, const KVINValue* axes, int from, int depth, char* isArray)
+{
+    for (int DD = from; DD < depth; ++DD)
+    {
+        isArray[DD]         = (axes[DD].type == KVIN_VAL_INTEGER);
+        kvinOutChar(out, isArray[DD] ? '[' : '{');
+        if (isArray[DD])
+        {
+            jsonNulls(out, axes[DD].integer);
+        }
+        else
+        {
+            jsonKey(out, &axes[DD]);
+        }
+    }
+}
+
+// Writes as it parses, so out has to be able to take back what it was given
+// if the input turns out not to be streamable (see jsonMark).
+static KVIN_JSON_STREAM kvinJsonStream(const char* name, const char* fst, const char* lst, KVINOut* out)
+{
+    static KVINValue    axes[KVIN_JSON_MAX_DEPTH];
+    static KVINValue    prev[KVIN_JSON_MAX_DEPTH];
+    static char         isArray[KVIN_JSON_MAX_DEPTH];
+    KVINParser          prs         = { };
+    KVINPath            path        = { };
+    int                 prevDepth   = 0;
+    int                 more        = 0;
+
+    kvinInitPath(&path, axes, KVIN_JSON_MAX_DEPTH);
+    if ((fst < lst) && kvinInitParser(&prs, fst, lst))
+    {
+        do
+        {
+            more            = kvinParseNext(&prs);
+            if (!kvinPathApply(&path, &prs))
+            {
+                kvinJsonError(name, fst, prs.lexer.lbeg, "path is too deep");
+                return KVIN_JSON_FAILED;
+            }
+            if ((prs.action != KVIN_ACT_SETVALUE) || (path.depth == 0))
+            {
+                continue;
+            }
+            if ((path.axes[0].type == KVIN_VAL_INTEGER) && (path.axes[0].integer > KVIN_JSON_MAX_INDEX))
+            {
+                return KVIN_JSON_UNSORTED;
+            }
+
+            int common      = 0;
+            if (prevDepth > 0)
+            {
+                while ((common < prevDepth) && (common < path.depth) && (kvinCompareAxis(&prev[common], &axes[common]) == 0))
+                {
+                    ++common;
+                }
+                if ((common == prevDepth) || (common == path.depth)
+                 || (kvinCompareAxis(&prev[common], &axes[common]) > 0)
+                 || (isArray[common] != (axes[common].type == KVIN_VAL_INTEGER))
+                 || (isArray[common] && (axes[common].integer > KVIN_JSON_MAX_INDEX)))
+                {
+                    return KVIN_JSON_UNSORTED;
+                }
+            }
+            for (int DD = common + 1; DD < path.depth; ++DD)
+            {
+                if ((axes[DD].type == KVIN_VAL_INTEGER) && (axes[DD].integer > KVIN_JSON_MAX_INDEX))
+                {
+                    return KVIN_JSON_UNSORTED;
+                }
+            }
+
+            if (prevDepth == 0)
+            {
+                jsonStreamOpen(out, axes, 0, path.depth, isArray);
+            }
+            else
+            {
+                for (int DD = prevDepth - 1; DD > common; --DD)
+                {
+                    kvinOutChar(out, isArray[DD] ? ']' : '}');
+                }
+                kvinOutChar(out, ',');
+                if (isArray[common])
+                {
+                    jsonNulls(out, axes[common].integer - prev[common].integer - 1);
+                }
+                else
+                {
+                    jsonKey(out, &axes[common]);
+                }
+                jsonStreamOpen(out, axes, common + 1, path.depth, isArray);
+            }
+            jsonValue(out, &prs.value, prs.lexer.lbeg, prs.lexer.lend);
+            for (int DD = common; DD < path.depth; ++DD)
+            {
+                prev[DD]    = axes[DD];
+            }
+            prevDepth       = path.depth;
+        }
+        while (more);
+
+        if (prs.state != KVIN_PAR_DONE)
+        {
+            kvinJsonParseError(name, fst, lst, &prs);
+            return KVIN_JSON_FAILED;
+        }
+    }
+
+    if (prevDepth == 0)
+    {
+        kvinOutPut(out, "{}", 2);
+    }
+    for (int DD = prevDepth - 1; DD >= 0; --DD)
+    {
+        kvinOutChar(out, isArray[DD] ? ']' : '}');
+    }
+    return KVIN_JSON_STREAMED;
+}
+
+typedef struct JArrayItem
+{
+    unsigned long long  index;
+    int                 node;
+} JArrayItem;
+
+static int jarrayItemCompare(const void* lhs, const void* rhs)
+{
+    const JArrayItem* lItem = (const JArrayItem*)lhs;
+    const JArrayItem* rItem = (const JArrayItem*)rhs;
+    return (lItem->index < rItem->index) ? -1 : (lItem->index > rItem->index);
+}
+
+static void jsonColumnValue(KVINOut* out, const KVINColumn* column, size_t II)
+{
+    if (column->type == KVIN_VAL_INTEGER)
+    {
+        kvinOutSigned(out, column->integers[II]);
+    }
+    else
+    {
+        jsonReal(out, column->reals[II]);
+    }
+}
+
+static void jsonColumn(KVINOut* out, const KVINColumn* column)
+{
+    if (column->base + column->length - 1 > KVIN_JSON_MAX_INDEX)
+    {
+        kvinOutChar(out, '{');
+        for (size_t II = 0; II < column->length; ++II)
+        {
+            KVINValue key;
+            key.type        = KVIN_VAL_INTEGER;
+            key.integer     = column->base + II;
+            if (II > 0)
+            {
+                kvinOutChar(out, ',');
+            }
+            jsonKey(out, &key);
+            jsonColumnValue(out, column, II);
+        }
+        kvinOutChar(out, '}');
+        return;
+    }
+    kvinOutChar(out, '[');
+    jsonNulls(out, column->base);
+    for (size_t II = 0; II < column->length; ++II)
+    {
+        if (II > 0)
+        {
+            kvinOutChar(out, ',');
+        }
+        jsonColumnValue(out, column, II);
+    }
+    kvinOutChar(out, ']');
+}
+
+static int jsonDocNode(const KVINDoc* doc, int idx, KVINOut* out)
+{
+    const KVINDocNode* node = &doc->nodes[idx];
+    const KVINColumn* column    = kvinDocColumn(doc, idx);
+    if (node->value.type != KVIN_VAL_NONE)
+    {
+        jsonValue(out, &node->value, 0, 0);
+        return 1;
+    }
+    if (column)
+    {
+        jsonColumn(out, column);
+        return 1;
+    }
+    if ((node->numChildren == 0) || (node->numInts != node->numChildren) || (node->maxIndex > KVIN_JSON_MAX_INDEX))
+    {
+        kvinOutChar(out, '{');
+        for (int child = node->first; child >= 0; child = doc->nodes[child].next)
+        {
+            if (child != node->first)
+            {
+                kvinOutChar(out, ',');
+            }
+            jsonKey(out, &doc->nodes[child].key);
+            if (!jsonDocNode(doc, child, out))
+            {
+                return 0;
+            }
+        }
+        kvinOutChar(out, '}');
+        return 1;
+    }
+
+    JArrayItem* items       = (JArrayItem*)malloc(node->numChildren * sizeof(JArrayItem));
+    int         numItems    = 0;
+    int         sorted      = 1;
+    if (!items)
+    {
+        return 0;
+    }
+    for (int child = node->first; child >= 0; child = doc->nodes[child].next, ++numItems)
+    {
+        items[numItems].index   = doc->nodes[child].key.integer;
+        items[numItems].node    = child;
+        sorted             &= !numItems || (items[numItems - 1].index < items[numItems].index);
+    }
+    if (!sorted)
+    {
+        qsort(items, numItems, sizeof(JArrayItem), jarrayItemCompare);
+    }
+
+    int ok                  = 1;
+    kvinOutChar(out, '[');
+    for (int II = 0; ok && (II < numItems); ++II)
+    {
+        if (II > 0)
+        {
+            kvinOutChar(out, ',');
+        }
+        jsonNulls(out, items[II].index - (II ? items[II - 1].index + 1 : 0));
+        ok                  = jsonDocNode(doc, items[II].node, out);
+    }
+    kvinOutChar(out, ']');
+    free(items);
+    return ok;
+}
+
+static int kvinJsonTree(const char* name, const char* fst, const char* lst, KVINOut* out)
+{
+    static KVINValue    axes[KVIN_JSON_MAX_DEPTH];
+    KVINDoc             doc         = { };
+    KVINParser          prs         = { };
+    KVINPath            path        = { };
+    int                 ok          = 0;
+
+    kvinInitPath(&path, axes, KVIN_JSON_MAX_DEPTH);
+    if (!kvinInitDoc(&doc, kvinStdRealloc, 0))
+    {
+        fprintf(stderr, "%s: out of memory\n", name);
+        return 0;
+    }
+    if ((fst < lst) && kvinInitParser(&prs, fst, lst) && !kvinDocLoad(&doc, &prs, &path))
+    {
+        if (prs.state == KVIN_PAR_ERROR)
+        {
+            kvinJsonParseError(name, fst, lst, &prs);
+        }
+        else
+        {
+            kvinJsonError(name, fst, prs.lexer.lbeg, (path.depth == path.capacity) ? "path is too deep" : "out of memory");
+        }
+    }
+    else
+    if (!(ok = jsonDocNode(&doc, 0, out)))
+    {
+        fprintf(stderr, "%s: out of memory\n", name);
+    }
+    kvinFreeDoc(&doc);
+    return ok;
+}
+
+// Output that the stream may take back. A regular file is written through, and
+// truncated back to the mark; anything else is held in memory until commit.
+static long jsonMark(KVINOut* out)
+{
+    struct stat st;
+    long        mark        = -1;
+    kvinOutFlush(out);
+    fflush(out->fp);
+    if ((fstat(fileno(out->fp), &st) == 0) && S_ISREG(st.st_mode))
+    {
+        mark                = ftell(out->fp);
+    }
+    out->hold               = (mark < 0);
+    return mark;
+}
+
+static void jsonUnwind(KVINOut* out, long mark)
+{
+    kvinOutDiscard(out);
+    if (mark >= 0)
+    {
+        fflush(out->fp);
+        if ((ftruncate(fileno(out->fp), mark) != 0) || (fseek(out->fp, mark, SEEK_SET) != 0))
+        {
+            perror("tojson");
+        }
+    }
+}
+
+// 0 if held output was lost to a lack of memory.
+static int jsonCommit(KVINOut* out, long mark)
+{
+    int ok                  = !out->failed;
+    if (ok)
+    {
+        kvinOutRelease(out);
+    }
+    else
+    {
+        jsonUnwind(out, mark);
+    }
+    return ok;
+}
+
+int kvinToJson(const char* name, const char* fst, const char* lst, KVINOut* out)
+{
+    long    mark            = jsonMark(out);
+    switch (kvinJsonStream(name, fst, lst, out))
+    {
+    case KVIN_JSON_STREAMED :
+        if (!jsonCommit(out, mark))
+        {
+            fprintf(stderr, "%s: out of memory\n", name);
+            return 0;
+        }
+        return 1;
+    case KVIN_JSON_UNSORTED :
+        jsonUnwind(out, mark);
+        return kvinJsonTree(name, fst, lst, out);
+    default                 :
+        jsonUnwind(out, mark);
+        return 0;
+    }
+}
+
+int toJsonMain(int argc, char *argv[])
+{
+    static KVINOut  out     = { };
+    int             bad     = 0;
+
+    out.fp                  = stdout;
+    for (int FF = 0; FF < argc; ++FF)
+    {
+        long    size        = 0;
+        int     mapped      = 0;
+        char   *kvin        = mapFile(argv[FF], &size, &mapped);
+        if (!kvin)
+        {
+            fprintf(stderr, "%s: cannot read\n", argv[FF]);
+            ++bad;
+            continue;
+        }
+        bad                += !kvinToJson(argv[FF], kvin, kvin + size, &out);
+        kvinOutChar(&out, '\n');
+        unmapFile(kvin, size, mapped);
+    }
+    kvinOutFlush(&out);
+    return !!bad;
+}
+
+// JSON to KVIN. The JSON path is a stack of axes whose identifiers live in a
+// string pool; `common` is how much of it is shared with the last written
+// path, and `diverged` is the axis that was replaced where they part.
+typedef struct JAxis
+{
+    int                 isInt;
+    unsigned long long  index;
+    size_t              off;
+    size_t              len;
+} JAxis;
+
+typedef struct JsonToKvin
+{
+    const char         *name;
+    const char         *fst;
+    const char         *cur;
+    const char         *lst;
+    KVINOut            *out;
+    JAxis               axes[KVIN_JSON_MAX_DEPTH];
+    char                kinds[KVIN_JSON_MAX_DEPTH];
+    int                 depth;
+    int                 numContainers;
+    char               *pool;
+    size_t              poolSize;
+    size_t              poolCap;
+    char               *text;
+    size_t              textSize;
+    size_t              textCap;
+    int                 common;
+    int                 prevDepth;
+    int                 haveDiverged;
+    JAxis               diverged;
+} JsonToKvin;
+
+static int jerror(JsonToKvin* js, const char* msg)
+{
+    kvinJsonError(js->name, js->fst, (js->cur < js->lst) ? js->cur : js->lst, msg);
+    return 0;
+}
+
+static void jwarn(JsonToKvin* js, const char* at, const char* msg)
+{
+    int lineNo  = 0;
+    int column  = 0;
+    kvinLocate(js->fst, at, &lineNo, &column);
+    fprintf(stderr, "%s:%d:%d: warning: %s\n", js->name, lineNo, column, msg);
+}
+
+static void jskipWs(JsonToKvin* js)
+{
+    while ((js->cur < js->lst) && ((*js->cur == ' ') || (*js->cur == '\t') || (*js->cur == '\n') || (*js->cur == '\r')))
+    {
+        ++js->cur;
+    }
+}
+
+static int jreserve(char** buf, size_t* cap, size_t size)
+{
+    if (size <= *cap)
+    {
+        return 1;
+    }
+    size_t  grown   = *cap ? *cap : 256;
+    while (grown < size)
+    {
+        grown      *= 2;
+    }
+    char   *mem     = (char*)realloc(*buf, grown);
+    if (!mem)
+    {
+        return 0;
+    }
+    *buf            = mem;
+    *cap            = grown;
+    return 1;
+}
+
+static int jhex4(const char* cur, unsigned* code)
+{
+    *code           = 0;
+    for (int HH = 0; HH < 4; ++HH)
+    {
+        if (!isxdigit((unsigned char)cur[HH]))
+        {
+            return 0;
+        }
+        *code       = (*code << 4) | (isdigit((unsigned char)cur[HH]) ? (cur[HH] - '0') : ((cur[HH] | 0x20) - 'a' + 10));
+    }
+    return 1;
+}
+
+// Reads a JSON string, unescaped to UTF-8, into js->text.
+static int jparseString(JsonToKvin* js)
+{
+    js->textSize            = 0;
+    if ((js->cur >= js->lst) || (*js->cur != '"'))
+    {
+        return jerror(js, "expected a string");
+    }
+    ++js->cur;
+    for (;;)
+    {
+        const char* run     = js->cur;
+        while ((js->cur < js->lst) && (*js->cur != '"') && (*js->cur != '\\') && ((unsigned char)*js->cur >= 0x20))
+        {
+            ++js->cur;
+        }
+        if (!jreserve(&js->text, &js->textCap, js->textSize + (js->cur - run) + 4))
+        {
+            return jerror(js, "out of memory");
+        }
+        memcpy(js->text + js->textSize, run, js->cur - run);
+        js->textSize       += js->cur - run;
+        if (js->cur >= js->lst)
+        {
+            return jerror(js, "unterminated string");
+        }
+        if (*js->cur == '"')
+        {
+            ++js->cur;
+            return 1;
+        }
+        if (*js->cur != '\\')
+        {
+            return jerror(js, "control character in string");
+        }
+        if (++js->cur >= js->lst)
+        {
+            return jerror(js, "unterminated string");
+        }
+        char*       dst     = js->text + js->textSize;
+        unsigned    code    = 0;
+        switch (*js->cur++)
+        {
+        case '"'    : *dst++ = '"';  break;
+        case '\\'   : *dst++ = '\\'; break;
+        case '/'    : *dst++ = '/';  break;
+        case 'b'    : *dst++ = '\b'; break;
+        case 'f'    : *dst++ = '\f'; break;
+        case 'n'    : *dst++ = '\n'; break;
+        case 'r'    : *dst++ = '\r'; break;
+        case 't'    : *dst++ = '\t'; break;
+        case 'u'    :
+            if ((js->lst - js->cur < 4) || !jhex4(js->cur, &code))
+            {
+                return jerror(js, "bad \\u escape");
+            }
+            js->cur        += 4;
+            if ((code >= 0xD800) && (code < 0xDC00) && (js->lst - js->cur >= 6)
+             && (js->cur[0] == '\\') && (js->cur[1] == 'u'))
+            {
+                unsigned low    = 0;
+                if (jhex4(js->cur + 2, &low) && (low >= 0xDC00) && (low < 0xE000))
+                {
+                    code        = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    js->cur    += 6;
+                }
+            }
+            if (code < 0x80)
+            {
+                *dst++      = (char)code;
+            }
+            else
+            if (code < 0x800)
+            {
+                *dst++      = (char)(0xC0 | (code >> 6));
+                *dst++      = (char)(0x80 | (code & 0x3F));
+            }
+            else
+            if (code < 0x10000)
+            {
+                *dst++      = (char)(0xE0 | (code >> 12));
+                *dst++      = (char)(0x80 | ((code >> 6) & 0x3F));
+                *dst++      = (char)(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                *dst++      = (char)(0xF0 | (code >> 18));
+                *dst++      = (char)(0x80 | ((code >> 12) & 0x3F));
+                *dst++      = (char)(0x80 | ((code >> 6) & 0x3F));
+                *dst++      = (char)(0x80 | (code & 0x3F));
+            }
+            break;
+        default     : return jerror(js, "bad escape");
+        }
+        js->textSize        = dst - js->text;
+    }
+}
+
+static int jisIdentifier(const char* str, size_t len)
+{
+    if ((len == 0) || !(isalpha((unsigned char)str[0]) || (str[0] == '_')))
+    {
+        return 0;
+    }
+    for (size_t II = 1; II < len; ++II)
+    {
+        if (!(isalnum((unsigned char)str[II]) || (str[II] == '_')))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int jpush(JsonToKvin* js, int isInt, unsigned long long index, const char* str, size_t len)
+{
+    if (js->depth == KVIN_JSON_MAX_DEPTH)
+    {
+        return jerror(js, "path is too deep");
+    }
+    if ((js->depth == js->common) && !js->haveDiverged)
+    {
+        js->diverged        = js->axes[js->depth];
+        js->haveDiverged    = 1;
+    }
+    JAxis* axis             = &js->axes[js->depth++];
+    axis->isInt             = isInt;
+    axis->index             = index;
+    axis->off               = js->poolSize;
+    axis->len               = len;
+    if (len)
+    {
+        if (!jreserve(&js->pool, &js->poolCap, js->poolSize + len))
+        {
+            return jerror(js, "out of memory");
+        }
+        memcpy(js->pool + js->poolSize, str, len);
+        js->poolSize       += len;
+    }
+    return 1;
+}
+
+static void jpop(JsonToKvin* js)
+{
+    js->poolSize            = js->axes[--js->depth].off;
+    if (js->depth < js->common)
+    {
+        js->common          = js->depth;
+        js->haveDiverged    = 0;
+    }
+}
+
+static int jparseKey(JsonToKvin* js)
+{
+    jskipWs(js);
+    if (!jparseString(js))
+    {
+        return 0;
+    }
+    jskipWs(js);
+    if ((js->cur >= js->lst) || (*js->cur != ':'))
+    {
+        return jerror(js, "expected ':'");
+    }
+    ++js->cur;
+
+    const char* key         = js->text;
+    size_t      len         = js->textSize;
+    if (jisIdentifier(key, len))
+    {
+        return jpush(js, 0, 0, key, len);
+    }
+    unsigned long long index    = 0;
+    size_t      II          = 0;
+    for (; (II < len) && isdigit((unsigned char)key[II]) && (index <= (~0ull - 9) / 10); ++II)
+    {
+        index               = 10 * index + (key[II] - '0');
+    }
+    if ((len == 0) || (II != len) || ((key[0] == '0') && (len > 1)))
+    {
+        return jerror(js, "key is neither an identifier nor an integer");
+    }
+    return jpush(js, 1, index, 0, 0);
+}
+
+static void jwriteAxis(JsonToKvin* js, const JAxis* axis, int dotted)
+{
+    if (axis->isInt)
+    {
+        kvinOutChar(js->out, '[');
+        kvinOutUnsigned(js->out, axis->index);
+        kvinOutChar(js->out, ']');
+        return;
+    }
+    if (dotted)
+    {
+        kvinOutChar(js->out, '.');
+    }
+    kvinOutPut(js->out, js->pool + axis->off, axis->len);
+}
+
+static void jwriteBString(KVINOut* out, const char* str, size_t len)
+{
+    static const char HEX[] = "0123456789abcdef";
+
+    kvinOutChar(out, '"');
+    const char* run         = str;
+    const char* end         = str + len;
+    for (const char* cur = str; cur < end; ++cur)
+    {
+        unsigned char c     = (unsigned char)*cur;
+        if ((c >= 0x20) && (c != 0x7F) && (c != '"') && (c != '\\'))
+        {
+            continue;
+        }
+        kvinOutPut(out, run, cur - run);
+        switch (c)
+        {
+        case '"'    : kvinOutPut(out, "\\\"", 2); break;
+        case '\\'   : kvinOutPut(out, "\\\\", 2); break;
+        case '\n'   : kvinOutPut(out, "\\n", 2); break;
+        case '\t'   : kvinOutPut(out, "\\t", 2); break;
+        case '\r'   : kvinOutPut(out, "\\r", 2); break;
+        default     :
+        {
+            char esc[4] = { '\\', 'x', HEX[c >> 4], HEX[c & 0xF] };
+            kvinOutPut(out, esc, sizeof(esc));
+            break;
+        }
+        }
+        run                 = cur + 1;
+    }
+    kvinOutPut(out, run, end - run);
+    kvinOutChar(out, '"');
+}
+
+// Writes the current path relative to the previous one, then " = ".
+static void jwritePath(JsonToKvin* js)
+{
+    int from                = 0;
+    if (js->prevDepth && js->common)
+    {
+        for (int DD = js->common; DD < js->prevDepth; ++DD)
+        {
+            kvinOutChar(js->out, '.');
+        }
+        const JAxis* axis   = &js->axes[js->common];
+        if (axis->isInt && js->haveDiverged && js->diverged.isInt && (axis->index == js->diverged.index + 1))
+        {
+            kvinOutChar(js->out, '#');
+        }
+        else
+        {
+            jwriteAxis(js, axis, 0);
+        }
+        from                = js->common + 1;
+    }
+    else
+    {
+        jwriteAxis(js, &js->axes[0], 0);
+        from                = 1;
+    }
+    for (int DD = from; DD < js->depth; ++DD)
+    {
+        jwriteAxis(js, &js->axes[DD], 1);
+    }
+    kvinOutPut(js->out, " = ", 3);
+
+    js->common              = js->depth;
+    js->prevDepth           = js->depth;
+    js->haveDiverged        = 0;
+}
+
+static int jparseScalar(JsonToKvin* js)
+{
+    const char* beg         = js->cur;
+    char        c           = *js->cur;
+    if (c == '"')
+    {
+        if (!jparseString(js))
+        {
+            return 0;
+        }
+        jwritePath(js);
+        if (jisIdentifier(js->text, js->textSize))
+        {
+            kvinOutPut(js->out, js->text, js->textSize);
+        }
+        else
+        {
+            jwriteBString(js->out, js->text, js->textSize);
+        }
+    }
+    else
+    if ((c == '-') || isdigit((unsigned char)c))
+    {
+        int     isReal      = 0;
+        js->cur             = jsonNumberEnd(beg, js->lst, &isReal);
+        if (!js->cur)
+        {
+            js->cur         = beg;
+            return jerror(js, "malformed number");
+        }
+        const char* digits  = beg + (c == '-');
+        size_t  numDigits   = js->cur - digits;
+        jwritePath(js);
+        kvinOutPut(js->out, beg, js->cur - beg);
+        // KVIN integers are signed 64-bit; anything else has to be a real.
+        const char* limit   = (c == '-') ? "9223372036854775808" : "9223372036854775807";
+        if (!isReal && ((numDigits > 19) || ((numDigits == 19) && (memcmp(digits, limit, 19) > 0))))
+        {
+            kvinOutPut(js->out, ".0", 2);
+        }
+    }
+    else
+    {
+        static const char* WORDS[] = { "true", "false", "null" };
+        size_t  len         = 0;
+        for (int WW = 0; !len && (WW < 3); ++WW)
+        {
+            size_t  wlen    = strlen(WORDS[WW]);
+            if (((size_t)(js->lst - js->cur) >= wlen) && (memcmp(js->cur, WORDS[WW], wlen) == 0))
+            {
+                len         = wlen;
+            }
+        }
+        if (!len)
+        {
+            return jerror(js, "expected a value");
+        }
+        js->cur            += len;
+        jwritePath(js);
+        kvinOutPut(js->out, beg, len);
+    }
+    kvinOutChar(js->out, '\n');
+    return 1;
+}
+
+// After a value: 1 if another value is expected, 2 at the end, 0 on error.
+static int jafterValue(JsonToKvin* js)
+{
+    for (;;)
+    {
+        jskipWs(js);
+        if (js->numContainers == 0)
+        {
+            return (js->cur < js->lst) ? jerror(js, "trailing characters") : 2;
+        }
+        if (js->cur >= js->lst)
+        {
+            return jerror(js, "unexpected end of input");
+        }
+        char kind           = js->kinds[js->numContainers - 1];
+        if (*js->cur == ',')
+        {
+            ++js->cur;
+            unsigned long long next = js->axes[js->depth - 1].index + 1;
+            jpop(js);
+            return (kind == '{') ? jparseKey(js) : jpush(js, 1, next, 0, 0);
+        }
+        if (*js->cur != ((kind == '{') ? '}' : ']'))
+        {
+            return jerror(js, (kind == '{') ? "expected ',' or '}'" : "expected ',' or ']'");
+        }
+        ++js->cur;
+        jpop(js);
+        --js->numContainers;
+    }
+}
+
+static int jconvert(JsonToKvin* js)
+{
+    for (;;)
+    {
+        jskipWs(js);
+        if (js->cur >= js->lst)
+        {
+            return jerror(js, "unexpected end of input");
+        }
+        char c              = *js->cur;
+        int  after          = 0;
+        if ((c == '{') || (c == '['))
+        {
+            if (js->numContainers == KVIN_JSON_MAX_DEPTH)
+            {
+                return jerror(js, "too deeply nested");
+            }
+            js->kinds[js->numContainers++]  = c;
+            ++js->cur;
+            jskipWs(js);
+            if ((js->cur < js->lst) && (*js->cur == ((c == '{') ? '}' : ']')))
+            {
+                // KVIN only has paths to values, so there is nothing to write.
+                jwarn(js, js->cur - 1, (c == '{') ? "empty object dropped" : "empty array dropped");
+                ++js->cur;
+                --js->numContainers;
+                after       = jafterValue(js);
+            }
+            else
+            {
+                after       = (c == '{') ? jparseKey(js) : jpush(js, 1, 0, 0, 0);
+            }
+        }
+        else
+        if (js->numContainers == 0)
+        {
+            return jerror(js, "top-level value must be an object or an array");
+        }
+        else
+        {
+            after           = jparseScalar(js) ? jafterValue(js) : 0;
+        }
+        if (after != 1)
+        {
+            return after;
+        }
+    }
+}
+
+int kvinFromJson(const char* name, const char* fst, const char* lst, KVINOut* out)
+{
+    static JsonToKvin   js;
+    js.name                     = name;
+    js.fst                      = fst;
+    js.cur                      = fst;
+    js.lst                      = lst;
+    js.out                      = out;
+    js.depth                    = 0;
+    js.numContainers            = 0;
+    js.poolSize                 = 0;
+    js.common                   = 0;
+    js.prevDepth                = 0;
+    js.haveDiverged             = 0;
+    int ok                      = jconvert(&js);
+    free(js.pool);
+    free(js.text);
+    js.pool                     = 0;
+    js.poolCap                  = 0;
+    js.text                     = 0;
+    js.textCap                  = 0;
+    return ok;
+}
+
+int fromJsonMain(int argc, char *argv[])
+{
+    static KVINOut      out     = { };
+    int                 bad     = 0;
+
+    out.fp                      = stdout;
+    for (int FF = 0; FF < argc; ++FF)
+    {
+        long    size            = 0;
+        char   *json            = readFile(argv[FF], &size);
+        if (!json)
+        {
+            fprintf(stderr, "%s: cannot read\n", argv[FF]);
+            ++bad;
+            continue;
+        }
+        bad                    += !kvinFromJson(argv[FF], json, json + size, &out);
+        free(json);
+    }
+    kvinOutFlush(&out);
+    return !!bad;
+}
@@ -0,0 +1,137 @@
+#ifndef KVINTOOL_H
+#define KVINTOOL_H
+
+// Shared pieces of the ./bin/kvin command line tool.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// readFile's copy is NUL-terminated; mapFile falls back to it for anything
+// that cannot be mapped, and *mapped says which one unmapFile must undo.
+char* readFile(const char* path, long* size);
+char* mapFile(const char* path, long* size, int* mapped);
+void unmapFile(char* data, long size, int mapped);
+
+int toJsonMain(int argc, char *argv[]);
+int fromJsonMain(int argc, char *argv[]);
+int diffMain(int argc, char *argv[]);
+
+// A buffered writer; fwrite per value is far too slow for conversion. While
+// hold is set, what would be written is kept in memory instead, so that it can
+// still be taken back (kvinOutDiscard) or written after all (kvinOutRelease).
+typedef struct KVINOut
+{
+    FILE           *fp;
+    size_t          size;
+    int             hold;
+    int             failed;         // Ran out of memory while holding.
+    char           *held;
+    size_t          heldSize;
+    size_t          heldCap;
+    char            buf[1 << 16];
+} KVINOut;
+
+static inline void kvinOutWrite(KVINOut* out, const char* str, size_t len)
+{
+    if (!out->hold)
+    {
+        fwrite(str, 1, len, out->fp);
+        return;
+    }
+    if (out->heldSize + len > out->heldCap)
+    {
+        size_t  cap         = 2 * out->heldCap + len;
+        char*   held        = (char*)realloc(out->held, cap);
+        if (!held)
+        {
+            out->failed     = 1;
+            return;
+        }
+        out->held           = held;
+        out->heldCap        = cap;
+    }
+    memcpy(out->held + out->heldSize, str, len);
+    out->heldSize          += len;
+}
+
+static inline void kvinOutFlush(KVINOut* out)
+{
+    if (out->size)
+    {
+        kvinOutWrite(out, out->buf, out->size);
+        out->size   = 0;
+    }
+}
+
+static inline void kvinOutRelease(KVINOut* out)
+{
+    kvinOutFlush(out);
+    out->hold       = 0;
+    kvinOutWrite(out, out->held, out->heldSize);
+    out->heldSize   = 0;
+}
+
+static inline void kvinOutDiscard(KVINOut* out)
+{
+    out->size       = 0;
+    out->hold       = 0;
+    out->failed     = 0;
+    out->heldSize   = 0;
+}
+
+static inline void kvinOutPut(KVINOut* out, const char* str, size_t len)
+{
+    if (out->size + len > sizeof(out->buf))
+    {
+        kvinOutFlush(out);
+        if (len > sizeof(out->buf))
+        {
+            kvinOutWrite(out, str, len);
+            return;
+        }
+    }
+    memcpy(out->buf + out->size, str, len);
+    out->size      += len;
+}
+
+static inline void kvinOutChar(KVINOut* out, char c)
+{
+    if (out->size == sizeof(out->buf))
+    {
+        kvinOutFlush(out);
+    }
+    out->buf[out->size++]   = c;
+}
+
+static inline void kvinOutUnsigned(KVINOut* out, unsigned long long ull)
+{
+    char    digits[24];
+    char   *cur     = digits + sizeof(digits);
+    do
+    {
+        *--cur      = (char)('0' + (ull % 10));
+        ull        /= 10;
+    }
+    while (ull);
+    kvinOutPut(out, cur, digits + sizeof(digits) - cur);
+}
+
+// An INTEGER value, which is signed: see pkvinIsSigned.
+static inline void kvinOutSigned(KVINOut* out, unsigned long long ull)
+{
+    if (ull >> 63)
+    {
+        kvinOutChar(out, '-');
+        ull         = 0ull - ull;
+    }
+    kvinOutUnsigned(out, ull);
+}
+
+// One input each; 0, once the error has been reported, if it fails.
+int kvinToJson(const char* name, const char* fst, const char* lst, KVINOut* out);
+int kvinFromJson(const char* name, const char* fst, const char* lst, KVINOut* out);
+int kvinDiff(const char* oldName, const char* oldFst, const char* oldLst,
+             const char* newName, const char* newFst, const char* newLst, size_t budget, KVINOut* out);
+
+#endif//KVINTOOL_H
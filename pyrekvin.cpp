@@ -0,0 +1,508 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "rekvin.h"
+
+static const char* sPyLEXEME[] =
+{
+#undef  KVIN_LEXEME_ENTRY
+#define KVIN_LEXEME_ENTRY(NAME) # NAME,
+KVIN_LEXEME_TABLE(KVIN_LEXEME_ENTRY)
+#undef  KVIN_LEXEME_ENTRY
+};
+
+// The text being parsed: either the UTF-8 of a str, or a bytes-like buffer.
+typedef struct PyKVINInput
+{
+    PyObject       *owner;
+    Py_buffer       view;
+    const char     *fst;
+    const char     *lst;
+} PyKVINInput;
+
+// The current absolute path, as kvinPathApply resolves it. keys[d] is the
+// Python key for axes[d], made when first needed, and nodes[d] the (borrowed)
+// dict it lives in; only keys[0..built) and nodes[0..resolved] are up to
+// date, so relative paths neither rebuild keys nor re-walk the tree.
+typedef struct PyKVINPath
+{
+    KVINPath        axes;
+    PyObject      **keys;
+    PyObject      **nodes;
+    Py_ssize_t      built;
+    Py_ssize_t      resolved;
+} PyKVINPath;
+
+static int pyKVINInitInput(PyKVINInput* in, PyObject* obj)
+{
+    in->owner               = 0;
+    in->view.obj            = 0;
+    if (PyUnicode_Check(obj))
+    {
+        Py_ssize_t size     = 0;
+        in->fst             = PyUnicode_AsUTF8AndSize(obj, &size);
+        if (!in->fst)
+        {
+            return 0;
+        }
+        in->lst             = in->fst + size;
+    }
+    else
+    {
+        if (PyObject_GetBuffer(obj, &in->view, PyBUF_SIMPLE) < 0)
+        {
+            return 0;
+        }
+        in->fst             = (const char*)in->view.buf;
+        in->lst             = in->fst + in->view.len;
+    }
+    Py_INCREF(obj);
+    in->owner               = obj;
+    return 1;
+}
+
+static void pyKVINFreeInput(PyKVINInput* in)
+{
+    if (in->view.obj)
+    {
+        PyBuffer_Release(&in->view);
+    }
+    Py_CLEAR(in->owner);
+}
+
+// Forgets the keys (and nodes) past the first depth axes.
+static void pyKVINPathKeep(PyKVINPath* path, Py_ssize_t depth)
+{
+    while (path->built > depth)
+    {
+        --path->built;
+        Py_CLEAR(path->keys[path->built]);
+    }
+    if (path->resolved > depth)
+    {
+        path->resolved      = depth;
+    }
+}
+
+static void pyKVINFreePath(PyKVINPath* path)
+{
+    pyKVINPathKeep(path, 0);
+    PyMem_Free(path->axes.axes);
+    PyMem_Free(path->keys);
+    PyMem_Free(path->nodes);
+    path->keys              = 0;
+    path->nodes             = 0;
+    kvinInitPath(&path->axes, 0, 0);
+}
+
+static int pyKVINPathGrow(PyKVINPath* path)
+{
+    int         capacity    = path->axes.capacity ? 2 * path->axes.capacity : 16;
+    KVINValue*  axes        = PyMem_Resize(path->axes.axes, KVINValue, capacity);
+    if (axes)
+    {
+        path->axes.axes     = axes;
+    }
+    PyObject**  keys        = axes ? PyMem_Resize(path->keys, PyObject*, capacity) : 0;
+    if (keys)
+    {
+        path->keys          = keys;
+    }
+    PyObject**  nodes       = keys ? PyMem_Resize(path->nodes, PyObject*, capacity) : 0;
+    if (!nodes)
+    {
+        PyErr_NoMemory();
+        return 0;
+    }
+    path->nodes             = nodes;
+    path->axes.capacity     = capacity;
+    return 1;
+}
+
+static PyObject* pyKVINAxis(KVINValue axis)
+{
+    if (axis.type == KVIN_VAL_INTEGER)
+    {
+        return PyLong_FromUnsignedLongLong(axis.integer);
+    }
+    PyObject* key           = PyUnicode_FromStringAndSize(axis.begin, axis.end - axis.begin);
+    if (key)
+    {
+        PyUnicode_InternInPlace(&key);
+    }
+    return key;
+}
+
+// A byte-string's text, decoded by kvinUnescape, as a str.
+static PyObject* pyKVINBString(const char* beg, const char* end)
+{
+    if (!memchr(beg, '\\', end - beg))
+    {
+        return PyUnicode_DecodeUTF8(beg, end - beg, "surrogateescape");
+    }
+    char*       buf         = (char*)PyMem_Malloc(end - beg);
+    Py_ssize_t  len         = 0;
+    if (!buf)
+    {
+        return PyErr_NoMemory();
+    }
+    for (const char* cur = beg; cur < end;)
+    {
+        buf[len++]          = (char)kvinUnescape(&cur, end);
+    }
+    PyObject*   str         = PyUnicode_DecodeUTF8(buf, len, "surrogateescape");
+    PyMem_Free(buf);
+    return str;
+}
+
+static PyObject* pyKVINValue(KVINValue value)
+{
+    switch (value.type)
+    {
+    case KVIN_VAL_IDENTIFIER    : return PyUnicode_FromStringAndSize(value.begin, value.end - value.begin);
+    case KVIN_VAL_INTEGER       : return PyLong_FromLongLong((long long)value.integer);
+    case KVIN_VAL_REAL          : return PyFloat_FromDouble((double)value.real);
+    case KVIN_VAL_BSTRING       : return pyKVINBString(value.begin, value.end);
+    default                     : break;
+    }
+    PyErr_SetString(PyExc_ValueError, "KVIN value has no type");
+    return 0;
+}
+
+static void pyKVINRaise(const PyKVINInput* in, const KVINParser* prs)
+{
+    int lineNo  = 0;
+    int column  = 0;
+    kvinLocate(in->fst, (prs->lexer.lbeg < in->lst) ? prs->lexer.lbeg : in->lst, &lineNo, &column);
+    PyErr_Format(PyExc_ValueError, "line %d, column %d: unexpected %s", lineNo, column, sPyLEXEME[prs->lexer.lex]);
+}
+
+// Applies a path action; returns 0 with an exception set on failure.
+static int pyKVINApplyPath(PyKVINPath* path, const KVINParser* prs)
+{
+    while (!kvinPathApply(&path->axes, prs))
+    {
+        if (!pyKVINPathGrow(path))
+        {
+            return 0;
+        }
+    }
+    // A new axis replaces whatever key was made for that depth before.
+    int pushed              = (prs->action == KVIN_ACT_SETATROOT) || (prs->action == KVIN_ACT_SETNEXTAXIS) || (prs->action == KVIN_ACT_AUTONUMBER);
+    pyKVINPathKeep(path, path->axes.depth - pushed);
+    return 1;
+}
+
+// Makes the keys of the current path that have not been made yet.
+static int pyKVINPathKeys(PyKVINPath* path)
+{
+    while (path->built < path->axes.depth)
+    {
+        if (!(path->keys[path->built] = pyKVINAxis(path->axes.axes[path->built])))
+        {
+            return 0;
+        }
+        ++path->built;
+    }
+    return 1;
+}
+
+// Stores value at the current path, replacing any scalar found on the way.
+static int pyKVINAssign(PyKVINPath* path, PyObject* root, PyObject* value)
+{
+    Py_ssize_t  depth       = path->axes.depth;
+    if (depth == 0)
+    {
+        return 1;
+    }
+    if (!pyKVINPathKeys(path))
+    {
+        return 0;
+    }
+    path->nodes[0]          = root;
+    for (Py_ssize_t DD = path->resolved; DD < depth - 1; ++DD)
+    {
+        PyObject* child     = PyDict_GetItemWithError(path->nodes[DD], path->keys[DD]);
+        if (!child && PyErr_Occurred())
+        {
+            return 0;
+        }
+        if (!child || !PyDict_Check(child))
+        {
+            child           = PyDict_New();
+            if (!child || (PyDict_SetItem(path->nodes[DD], path->keys[DD], child) < 0))
+            {
+                Py_XDECREF(child);
+                return 0;
+            }
+            Py_DECREF(child);
+        }
+        path->nodes[DD + 1] = child;
+    }
+    path->resolved          = depth - 1;
+    return PyDict_SetItem(path->nodes[depth - 1], path->keys[depth - 1], value) == 0;
+}
+
+// Same as kvin.py's InferArrays: a dict whose keys are all integers becomes a
+// list, with None in the holes, unless it would be mostly holes (see
+// pyKVINDense). Returns a new reference.
+// Whether count integer keys up to maxIndex make a list rather than a dict:
+// small ones always do, larger ones only if at least half the slots are used.
+static int pyKVINDense(Py_ssize_t count, Py_ssize_t maxIndex)
+{
+    return (maxIndex < 1024) || (maxIndex / 2 < count);
+}
+
+static PyObject* pyKVINInferArrays(PyObject* node)
+{
+    if (!PyDict_Check(node))
+    {
+        Py_INCREF(node);
+        return node;
+    }
+    if (Py_EnterRecursiveCall(" while inferring KVIN arrays"))
+    {
+        return 0;
+    }
+
+    int         isArray     = (PyDict_GET_SIZE(node) > 0);
+    Py_ssize_t  maxIndex    = -1;
+    Py_ssize_t  pos         = 0;
+    PyObject   *key         = 0;
+    PyObject   *value       = 0;
+    while (PyDict_Next(node, &pos, &key, &value))
+    {
+        PyObject* inferred  = pyKVINInferArrays(value);
+        if (!inferred || (PyDict_SetItem(node, key, inferred) < 0))
+        {
+            Py_XDECREF(inferred);
+            Py_LeaveRecursiveCall();
+            return 0;
+        }
+        Py_DECREF(inferred);
+        if (isArray && PyLong_CheckExact(key))
+        {
+            Py_ssize_t index    = PyLong_AsSsize_t(key);
+            if ((index == -1) && PyErr_Occurred())
+            {
+                PyErr_Clear();
+                isArray     = 0;
+            }
+            maxIndex        = (index > maxIndex) ? index : maxIndex;
+        }
+        else
+        {
+            isArray         = 0;
+        }
+    }
+    Py_LeaveRecursiveCall();
+
+    if (!isArray || !pyKVINDense(PyDict_GET_SIZE(node), maxIndex))
+    {
+        Py_INCREF(node);
+        return node;
+    }
+    PyObject* array         = PyList_New(maxIndex + 1);
+    if (!array)
+    {
+        return 0;
+    }
+    for (Py_ssize_t II = 0; II <= maxIndex; ++II)
+    {
+        Py_INCREF(Py_None);
+        PyList_SET_ITEM(array, II, Py_None);
+    }
+    pos                     = 0;
+    while (PyDict_Next(node, &pos, &key, &value))
+    {
+        Py_INCREF(value);
+        PyList_SetItem(array, PyLong_AsSsize_t(key), value);
+    }
+    return array;
+}
+
+static PyObject* pyKVINLoads(PyObject* /*module*/, PyObject* arg)
+{
+    PyKVINInput in          = { };
+    PyKVINPath  path        = { };
+    KVINParser  prs         = { };
+    PyObject*   root        = 0;
+    PyObject*   result      = 0;
+
+    kvinInitPath(&path.axes, 0, 0);
+    if (!pyKVINInitInput(&in, arg) || !(root = PyDict_New()))
+    {
+        goto done;
+    }
+    if ((in.fst < in.lst) && kvinInitParser(&prs, in.fst, in.lst))
+    {
+        int more            = 0;
+        do
+        {
+            more            = kvinParseNext(&prs);
+            if (!pyKVINApplyPath(&path, &prs))
+            {
+                goto done;
+            }
+            if (prs.action == KVIN_ACT_SETVALUE)
+            {
+                PyObject* value = pyKVINValue(prs.value);
+                int assigned    = value && pyKVINAssign(&path, root, value);
+                Py_XDECREF(value);
+                if (!assigned)
+                {
+                    goto done;
+                }
+            }
+        }
+        while (more);
+
+        if (prs.state != KVIN_PAR_DONE)
+        {
+            pyKVINRaise(&in, &prs);
+            goto done;
+        }
+    }
+    result                  = pyKVINInferArrays(root);
+
+done:
+    Py_XDECREF(root);
+    pyKVINFreePath(&path);
+    pyKVINFreeInput(&in);
+    return result;
+}
+
+typedef struct PyKVINIter
+{
+    PyObject_HEAD
+    PyKVINInput     in;
+    PyKVINPath      path;
+    KVINParser      prs;
+    int             exhausted;
+} PyKVINIter;
+
+static PyObject* pyKVINIterNext(PyKVINIter* self)
+{
+    while (!self->exhausted)
+    {
+        int more            = kvinParseNext(&self->prs);
+        self->exhausted     = !more;
+        if (!pyKVINApplyPath(&self->path, &self->prs))
+        {
+            return 0;
+        }
+        if (self->prs.action == KVIN_ACT_SETVALUE)
+        {
+            PyObject* value = pyKVINPathKeys(&self->path) ? pyKVINValue(self->prs.value) : 0;
+            PyObject* key   = value ? PyTuple_New(self->path.axes.depth) : 0;
+            if (!key)
+            {
+                Py_XDECREF(value);
+                return 0;
+            }
+            for (Py_ssize_t DD = 0; DD < self->path.axes.depth; ++DD)
+            {
+                Py_INCREF(self->path.keys[DD]);
+                PyTuple_SET_ITEM(key, DD, self->path.keys[DD]);
+            }
+            PyObject* pair  = PyTuple_Pack(2, key, value);
+            Py_DECREF(key);
+            Py_DECREF(value);
+            return pair;
+        }
+    }
+    if (self->prs.state == KVIN_PAR_ERROR)
+    {
+        self->prs.state     = KVIN_PAR_DONE;
+        pyKVINRaise(&self->in, &self->prs);
+    }
+    return 0;
+}
+
+static void pyKVINIterDealloc(PyKVINIter* self)
+{
+    PyTypeObject* type      = Py_TYPE(self);
+    pyKVINFreePath(&self->path);
+    pyKVINFreeInput(&self->in);
+    type->tp_free((PyObject*)self);
+    Py_DECREF(type);
+}
+
+static PyType_Slot sPyKVINIterSlots[] =
+{
+    { Py_tp_doc,        (void*)"Iterator of (path, value) pairs, in document order." },
+    { Py_tp_iter,       (void*)PyObject_SelfIter },
+    { Py_tp_iternext,   (void*)pyKVINIterNext },
+    { Py_tp_dealloc,    (void*)pyKVINIterDealloc },
+    { 0,                0 },
+};
+
+static PyType_Spec sPyKVINIterSpec =
+{
+    "rekvin.iterparse",
+    sizeof(PyKVINIter),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    sPyKVINIterSlots,
+};
+
+static PyObject* sPyKVINIterType = 0;
+
+static PyObject* pyKVINIterParse(PyObject* /*module*/, PyObject* arg)
+{
+    PyKVINIter* self        = PyObject_New(PyKVINIter, (PyTypeObject*)sPyKVINIterType);
+    if (!self)
+    {
+        return 0;
+    }
+    self->path              = PyKVINPath();
+    kvinInitPath(&self->path.axes, 0, 0);
+    self->prs               = KVINParser();
+    self->exhausted         = 1;
+    if (!pyKVINInitInput(&self->in, arg))
+    {
+        self->in            = PyKVINInput();
+        Py_DECREF(self);
+        return 0;
+    }
+    self->prs.state         = KVIN_PAR_DONE;
+    self->exhausted         = !((self->in.fst < self->in.lst) && kvinInitParser(&self->prs, self->in.fst, self->in.lst));
+    return (PyObject*)self;
+}
+
+static PyMethodDef sPyKVINMethods[] =
+{
+    { "loads",      pyKVINLoads,        METH_O, "Parse KVIN (str or bytes) into dicts and lists." },
+    { "iterparse",  pyKVINIterParse,    METH_O, "Iterate over the (path, value) pairs of KVIN (str or bytes)." },
+    { 0,            0,                  0,      0 },
+};
+
+static PyModuleDef sPyKVINModule =
+{
+    PyModuleDef_HEAD_INIT,
+    "rekvin",
+    "Key Value Inline Notation, parsed by rekvin.h.",
+    -1,
+    sPyKVINMethods,
+};
+
+PyMODINIT_FUNC PyInit_rekvin(void)
+{
+    PyObject* module        = PyModule_Create(&sPyKVINModule);
+    if (!module)
+    {
+        return 0;
+    }
+    sPyKVINIterType         = PyType_FromSpec(&sPyKVINIterSpec);
+    if (!sPyKVINIterType || (PyModule_AddObject(module, "iterparse_type", sPyKVINIterType) < 0))
+    {
+        Py_XDECREF(sPyKVINIterType);
+        Py_DECREF(module);
+        return 0;
+    }
+    Py_INCREF(sPyKVINIterType);
+    return module;
+}
+
+#define REKVIN_C
+#include "rekvin.h"
@@ -1,7 +1,21 @@
 #include "rekvin.h"
+#include "kvintool.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char* sLEXEME[] =
+{
+#undef  KVIN_LEXEME_ENTRY
+#define KVIN_LEXEME_ENTRY(NAME) # NAME,
+KVIN_LEXEME_TABLE(KVIN_LEXEME_ENTRY)
+#undef  KVIN_LEXEME_ENTRY
+};
 
 const char* sPARSES[] =
 {
@@ -19,6 +33,17 @@ KVIN_ACTION_TABLE(KVIN_ACTION_ENTRY)
 #undef  KVIN_ACTION_ENTRY
 };
 
+const char* sSCHEMA[] =
+{
+#undef  KVIN_SCHEMA_ERROR_ENTRY
+#define KVIN_SCHEMA_ERROR_ENTRY(NAME) # NAME,
+KVIN_SCHEMA_ERROR_TABLE(KVIN_SCHEMA_ERROR_ENTRY)
+#undef  KVIN_SCHEMA_ERROR_ENTRY
+};
+
+// Value types as a schema's `type` names them, in KVIN_VALUE order.
+const char* sTYPES[] = { "identifier", "integer", "real", "bstring" };
+
 void printLexeme(KVINLexer* lexer)
 {
     fprintf(stdout, "'%.*s'", (int)(lexer->lend - lexer->lbeg), lexer->lbeg);
@@ -30,6 +55,260 @@ typedef struct TEST
     const char*     kvin;
 } TEST;
 
+typedef struct ERRTEST
+{
+    const char*     kvin;
+    int             numErrs;
+    KVINError       errs[4];
+} ERRTEST;
+
+typedef struct PATHTEST
+{
+    const char*     kvin;
+    const char*     paths;
+} PATHTEST;
+
+typedef struct DIFFTEST
+{
+    const char*     older;
+    const char*     newer;
+    size_t          budget;             // Small ones force sorted runs to spill.
+    const char*     diff;
+} DIFFTEST;
+
+typedef struct LONGREALTEST
+{
+    const char*     head;               // Then count copies of fill, then tail.
+    const char*     fill;
+    int             count;
+    const char*     tail;
+} LONGREALTEST;
+
+typedef struct JSONTEST
+{
+    int             toJson;             // Otherwise from is JSON, to KVIN.
+    const char*     from;
+    const char*     to;
+    int             roundTrip;          // tojson of to gives from back.
+} JSONTEST;
+
+typedef struct SCHEMATEST
+{
+    const char*         schema;
+    const char*         kvin;           // Null to expect the schema itself to fail, with errs[0].
+    int                 numErrs;
+    KVINSchemaError     errs[6];        // Only kind, lineNo and column are compared.
+} SCHEMATEST;
+
+typedef struct DOCTEST
+{
+    const char*         kvin;
+    KVIN_VALUE          type;           // Of the column holding `t`, or NONE.
+    unsigned long long  base;
+    int                 length;         // Of the column, or number of children.
+    double              values[4];
+} DOCTEST;
+
+int checkDoc(const DOCTEST* test)
+{
+    KVINValue   axes[16];
+    KVINPath    path        = { };
+    KVINParser  parser      = { };
+    KVINDoc     doc         = { };
+    KVINValue   key         = { };
+    int         passed      = 0;
+    kvinInitPath(&path, axes, 16);
+    kvinInitParser(&parser, test->kvin, test->kvin + strlen(test->kvin));
+    key.type                = KVIN_VAL_IDENTIFIER;
+    key.begin               = "t";
+    key.end                 = key.begin + 1;
+    if (kvinInitDoc(&doc, kvinStdRealloc, 0) && kvinDocLoad(&doc, &parser, &path))
+    {
+        int node            = kvinDocFind(&doc, 0, &key);
+        const KVINColumn* column    = (node >= 0) ? kvinDocColumn(&doc, node) : 0;
+        if (column)
+        {
+            passed          = (column->type == test->type) && (column->base == test->base) && ((int)column->length == test->length);
+            for (int II = 0; passed && (II < test->length); ++II)
+            {
+                passed      = (column->type == KVIN_VAL_INTEGER)
+                            ? (column->integers[II] == (unsigned long long)test->values[II])
+                            : (column->reals[II] == test->values[II]);
+            }
+        }
+        else
+        {
+            passed          = (node >= 0) && (test->type == KVIN_VAL_NONE) && (doc.nodes[node].numChildren == test->length);
+        }
+    }
+    kvinFreeDoc(&doc);
+    return passed;
+}
+
+// Whether reals packed into t's column equal the same reals stored in u's
+// nodes, which keep the parser's long double, rounded to double.
+int checkPackedReals(const char* kvin)
+{
+    KVINValue   axes[16];
+    KVINPath    path        = { };
+    KVINParser  parser      = { };
+    KVINDoc     doc         = { };
+    KVINValue   key         = { };
+    int         passed      = 0;
+    kvinInitPath(&path, axes, 16);
+    kvinInitParser(&parser, kvin, kvin + strlen(kvin));
+    key.type                = KVIN_VAL_IDENTIFIER;
+    if (kvinInitDoc(&doc, kvinStdRealloc, 0) && kvinDocLoad(&doc, &parser, &path))
+    {
+        key.begin           = "t";
+        key.end             = key.begin + 1;
+        int packed          = kvinDocFind(&doc, 0, &key);
+        key.begin           = "u";
+        key.end             = key.begin + 1;
+        int unpacked        = kvinDocFind(&doc, 0, &key);
+        const KVINColumn* column    = (packed >= 0) ? kvinDocColumn(&doc, packed) : 0;
+        passed              = column && (column->type == KVIN_VAL_REAL) && (unpacked >= 0)
+                            && ((int)column->length == doc.nodes[unpacked].numChildren);
+        int child           = passed ? doc.nodes[unpacked].first : -1;
+        for (size_t II = 0; passed && (II < column->length); ++II, child = doc.nodes[child].next)
+        {
+            passed          = (doc.nodes[child].value.type == KVIN_VAL_REAL) && (column->reals[II] == (double)doc.nodes[child].value.real);
+        }
+    }
+    kvinFreeDoc(&doc);
+    return passed;
+}
+
+// Parses a real too long to convert on the stack, at the very end of a buffer
+// that goes on with more digits; they must not be read.
+int checkLongReal()
+{
+    char        kvin[256]   = "x = 1.";
+    KVINParser  parser      = { };
+    size_t      used        = strlen(kvin);
+    for (; used < sizeof(kvin) - 4; ++used)
+    {
+        kvin[used]          = '5';
+    }
+    long double expected    = strtold(kvin + 4, 0);
+    memcpy(kvin + used, "999", 4);
+    kvinInitParser(&parser, kvin, kvin + used);
+    while (kvinParseNext(&parser) && (parser.action != KVIN_ACT_SETVALUE))
+    {
+    }
+    return (parser.action == KVIN_ACT_SETVALUE) && (parser.value.type == KVIN_VAL_REAL) && (parser.value.real == expected);
+}
+
+// Whether the real test describes, too long to copy as it is, parses to what
+// strtold makes of all of it.
+int checkShortenedReal(const LONGREALTEST* test)
+{
+    char        kvin[1024]  = "x = ";
+    KVINParser  parser      = { };
+    strcat(kvin, test->head);
+    for (int CC = 0; CC < test->count; ++CC)
+    {
+        strcat(kvin, test->fill);
+    }
+    strcat(kvin, test->tail);
+    long double expected    = strtold(kvin + 4, 0);
+    kvinInitParser(&parser, kvin, kvin + strlen(kvin));
+    while (kvinParseNext(&parser) && (parser.action != KVIN_ACT_SETVALUE))
+    {
+    }
+    return (parser.action == KVIN_ACT_SETVALUE) && (parser.value.type == KVIN_VAL_REAL) && (parser.value.real == expected);
+}
+
+// Runs kvinDiff into buf, through a temporary file.
+int diffText(const DIFFTEST* test, char* buf, int size)
+{
+    KVINOut*    out         = (KVINOut*)calloc(1, sizeof(KVINOut));
+    int         numDiffs    = -1;
+    buf[0]                  = 0;
+    if (out && (out->fp = tmpfile()))
+    {
+        numDiffs            = kvinDiff("old", test->older, test->older + strlen(test->older),
+                                       "new", test->newer, test->newer + strlen(test->newer), test->budget, out);
+        kvinOutFlush(out);
+        rewind(out->fp);
+        buf[fread(buf, 1, size - 1, out->fp)]  = 0;
+        fclose(out->fp);
+    }
+    free(out);
+    return numDiffs;
+}
+
+// Runs kvinToJson or kvinFromJson on text into buf, through a temporary file;
+// 0 if the conversion fails.
+int convertText(int toJson, const char* text, char* buf, int size)
+{
+    KVINOut*    out         = (KVINOut*)calloc(1, sizeof(KVINOut));
+    int         ok          = 0;
+    buf[0]                  = 0;
+    if (out && (out->fp = tmpfile()))
+    {
+        ok                  = toJson ? kvinToJson("kvin", text, text + strlen(text), out)
+                                     : kvinFromJson("json", text, text + strlen(text), out);
+        kvinOutFlush(out);
+        rewind(out->fp);
+        buf[fread(buf, 1, size - 1, out->fp)]  = 0;
+        fclose(out->fp);
+    }
+    free(out);
+    return ok;
+}
+
+// Loads test->schema, then checks test->kvin against it; -1 if either fails
+// unexpectedly.
+int checkSchema(const SCHEMATEST* test, KVINSchemaError* errs, int maxErrs)
+{
+    KVINSchema  schema      = { };
+    int         numErrs     = -1;
+    if (kvinInitSchema(&schema, kvinStdRealloc, 0))
+    {
+        if (!kvinSchemaLoad(&schema, test->schema, test->schema + strlen(test->schema), &errs[0]))
+        {
+            numErrs         = test->kvin ? -1 : 1;
+        }
+        else
+        {
+            numErrs         = test->kvin ? kvinSchemaValidate(&schema, test->kvin, test->kvin + strlen(test->kvin), errs, maxErrs) : 0;
+        }
+    }
+    kvinFreeSchema(&schema);
+    return numErrs;
+}
+
+// Writes each assigned path, as "a.0.b;", to buf. Also checks that the lexer
+// counted every newline.
+int resolvePaths(const char* kvin, int validateOnly, char* buf, int size)
+{
+    KVINValue   axes[16];
+    KVINPath    path        = { };
+    KVINParser  parser      = { };
+    int         used        = 0;
+    int         lineNo      = 0;
+    buf[0]                  = 0;
+    kvinInitPath(&path, axes, 16);
+    kvinInitParser(&parser, kvin, kvin + strlen(kvin));
+    parser.validateOnly     = validateOnly;
+    while (kvinParseNext(&parser) && kvinPathApply(&path, &parser))
+    {
+        for (int DD = 0; (parser.action == KVIN_ACT_SETVALUE) && (DD < path.depth) && (used < size); ++DD)
+        {
+            const KVINValue* axis   = &path.axes[DD];
+            used   += (axis->type == KVIN_VAL_INTEGER)
+                    ? snprintf(buf + used, size - used, "%llu%s", axis->integer, (DD + 1 < path.depth) ? "." : ";")
+                    : snprintf(buf + used, size - used, "%.*s%s", (int)(axis->end - axis->begin), axis->begin, (DD + 1 < path.depth) ? "." : ";");
+        }
+    }
+    for (const char* cur = kvin; *cur; ++cur)
+    {
+        lineNo     += (*cur == '\n');
+    }
+    return (parser.state == KVIN_PAR_DONE) && (parser.lexer.lineNo == lineNo);
+}
+
 typedef struct MyKVIN
 {
     char X[1];
@@ -70,8 +349,290 @@ int myDone(MyKVIN* handle)
     return 0;
 }
 
+char* readFile(const char* path, long* size)
+{
+    FILE* fp        = fopen(path, "rb");
+    if (!fp)
+    {
+        return 0;
+    }
+    char* buf       = 0;
+    if ((fseek(fp, 0, SEEK_END) == 0) && ((*size = ftell(fp)) >= 0) && (fseek(fp, 0, SEEK_SET) == 0))
+    {
+        buf         = (char*)malloc(*size + 1);
+        if (buf && ((long)fread(buf, 1, *size, fp) != *size))
+        {
+            free(buf);
+            buf     = 0;
+        }
+        if (buf)
+        {
+            buf[*size]  = 0;
+        }
+    }
+    fclose(fp);
+    return buf;
+}
+
+// Maps a file read-only, so that inputs larger than memory are paged in and
+// out by the system; *mapped says whether to munmap or free it afterwards.
+char* mapFile(const char* path, long* size, int* mapped)
+{
+    struct stat     st;
+    int             fd      = open(path, O_RDONLY);
+    char*           data    = 0;
+    *mapped                 = 0;
+    if (fd < 0)
+    {
+        return 0;
+    }
+    if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && (st.st_size > 0))
+    {
+        void*       map     = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            data            = (char*)map;
+            *size           = (long)st.st_size;
+            *mapped         = 1;
+        }
+    }
+    close(fd);
+    return data ? data : readFile(path, size);
+}
+
+void unmapFile(char* data, long size, int mapped)
+{
+    if (mapped)
+    {
+        munmap(data, size);
+    }
+    else
+    {
+        free(data);
+    }
+}
+
+int validateMain(int argc, char *argv[])
+{
+    enum { MAX_ERRS = 64 };
+    KVINError errs[MAX_ERRS];
+    int numBad      = 0;
+
+    for (int FF = 0; FF < argc; ++FF)
+    {
+        long size   = 0;
+        char* kvin  = readFile(argv[FF], &size);
+        if (!kvin)
+        {
+            fprintf(stderr, "%s: cannot read\n", argv[FF]);
+            ++numBad;
+            continue;
+        }
+        int numErrs = kvinValidate(kvin, kvin + size, errs, MAX_ERRS);
+        for (int EE = 0; (EE < numErrs) && (EE < MAX_ERRS); ++EE)
+        {
+            fprintf(stderr, "%s:%d:%d: error: unexpected %s in %s\n",
+                argv[FF], errs[EE].lineNo, errs[EE].column, sLEXEME[errs[EE].lex], sPARSES[errs[EE].state]);
+        }
+        if (numErrs > MAX_ERRS)
+        {
+            fprintf(stderr, "%s: %d more errors\n", argv[FF], numErrs - MAX_ERRS);
+        }
+        numBad     += !!numErrs;
+        free(kvin);
+    }
+
+    return !!numBad;
+}
+
+// Writes a schema node's path as its rules name it, e.g. "workers[*].name".
+void schemaPath(const KVINSchema* schema, int node, char* buf, int size)
+{
+    int     chain[64];
+    int     depth   = 0;
+    int     used    = 0;
+    buf[0]          = 0;
+    for (; (node > 0) && (depth < 64); node = schema->nodes[node].parent)
+    {
+        chain[depth++]  = node;
+    }
+    while ((depth-- > 0) && (used < size))
+    {
+        const KVINSchemaNode*   step    = &schema->nodes[chain[depth]];
+        const char*             dot     = used ? "." : "";
+        if (step->key.type == KVIN_VAL_IDENTIFIER)
+        {
+            used   += snprintf(buf + used, size - used, "%s%.*s", dot, (int)(step->key.end - step->key.begin), step->key.begin);
+        }
+        else
+        if (step->key.type == KVIN_VAL_INTEGER)
+        {
+            used   += snprintf(buf + used, size - used, "[%llu]", step->key.integer);
+        }
+        else
+        {
+            used   += (schema->nodes[step->parent].anyIndex == chain[depth])
+                    ? snprintf(buf + used, size - used, "[*]")
+                    : snprintf(buf + used, size - used, "%s*", dot);
+        }
+    }
+}
+
+void schemaValue(const KVINValue* value, char* buf, int size)
+{
+    switch (value->type)
+    {
+    case KVIN_VAL_INTEGER       : snprintf(buf, size, "%lld", (long long)value->integer);   break;
+    case KVIN_VAL_REAL          : snprintf(buf, size, "%Lg", value->real);                  break;
+    case KVIN_VAL_BSTRING       : snprintf(buf, size, "\"%.*s\"", (int)(value->end - value->begin), value->begin); break;
+    default                     : snprintf(buf, size, "%.*s", (int)(value->end - value->begin), value->begin); break;
+    }
+}
+
+void printSchemaError(const char* name, const KVINSchema* schema, const KVINSchemaError* err)
+{
+    char    path[256];
+    char    value[64];
+    char    detail[192];
+    int     used            = 0;
+    detail[0]               = 0;
+    schemaPath(schema, (err->node >= 0) ? err->node : 0, path, sizeof(path));
+    if (err->value.type != KVIN_VAL_NONE)
+    {
+        schemaValue(&err->value, value, sizeof(value));
+    }
+    if (err->lineNo)
+    {
+        fprintf(stderr, "%s:%d:%d: error: ", name, err->lineNo, err->column);
+    }
+    else
+    {
+        fprintf(stderr, "%s: error: ", name);
+    }
+    switch (err->kind)
+    {
+    case KVIN_SCH_SYNTAX        : fprintf(stderr, "not KVIN (see kvin validate)\n");    break;
+    case KVIN_SCH_DEPTH         : fprintf(stderr, "paths are nested too deeply\n");     break;
+    case KVIN_SCH_RULE          : fprintf(stderr, "not a rule\n");                      break;
+    case KVIN_SCH_TYPE          :
+        for (int TT = 0; TT < (int)(sizeof(sTYPES) / sizeof(sTYPES[0])); ++TT)
+        {
+            if (schema->nodes[err->node].types & (1 << TT))
+            {
+                used       += snprintf(detail + used, sizeof(detail) - used, "%s%s", used ? " or " : "", sTYPES[TT]);
+            }
+        }
+        fprintf(stderr, "%s takes %s, not %s %s\n", path, used ? detail : "keys", sTYPES[err->value.type], value);
+        break;
+    case KVIN_SCH_RANGE         :
+        if (schema->nodes[err->node].min.type != KVIN_VAL_NONE)
+        {
+            schemaValue(&schema->nodes[err->node].min, detail, sizeof(detail) / 2);
+            used            = (int)strlen(detail);
+        }
+        used               += snprintf(detail + used, sizeof(detail) - used, "..");
+        if (schema->nodes[err->node].max.type != KVIN_VAL_NONE)
+        {
+            schemaValue(&schema->nodes[err->node].max, detail + used, sizeof(detail) - used);
+        }
+        fprintf(stderr, "%s = %s is outside %s\n", path, value, detail);
+        break;
+    case KVIN_SCH_UNKNOWN       :
+        if (err->value.type == KVIN_VAL_INTEGER)
+        {
+            snprintf(value, sizeof(value), "[%llu]", err->value.integer);
+        }
+        fprintf(stderr, "unknown key %s in %s\n", value, path[0] ? path : "the top level");
+        break;
+    case KVIN_SCH_MISSING       : fprintf(stderr, "%s is required\n", path);            break;
+    default                     : break;
+    }
+}
+
+// Checks each FILE against the rules in SCHEMA; see README.md.
+int checkMain(int argc, char *argv[])
+{
+    enum { MAX_ERRS = 64 };
+    KVINSchemaError errs[MAX_ERRS];
+    KVINSchema      schema      = { };
+    long            size        = 0;
+    int             numBad      = 0;
+    char*           rules       = (argc > 1) ? readFile(argv[0], &size) : 0;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: kvin check SCHEMA FILE...\n");
+        return 2;
+    }
+    if (!rules || !kvinInitSchema(&schema, kvinStdRealloc, 0))
+    {
+        fprintf(stderr, "%s: cannot read\n", argv[0]);
+        free(rules);
+        return 2;
+    }
+    if (!kvinSchemaLoad(&schema, rules, rules + size, &errs[0]))
+    {
+        printSchemaError(argv[0], &schema, &errs[0]);
+        kvinFreeSchema(&schema);
+        free(rules);
+        return 2;
+    }
+
+    for (int FF = 1; FF < argc; ++FF)
+    {
+        char* kvin  = readFile(argv[FF], &size);
+        if (!kvin)
+        {
+            fprintf(stderr, "%s: cannot read\n", argv[FF]);
+            ++numBad;
+            continue;
+        }
+        int numErrs = kvinSchemaValidate(&schema, kvin, kvin + size, errs, MAX_ERRS);
+        if (numErrs < 0)
+        {
+            fprintf(stderr, "%s: out of memory\n", argv[FF]);
+        }
+        for (int EE = 0; (EE < numErrs) && (EE < MAX_ERRS); ++EE)
+        {
+            printSchemaError(argv[FF], &schema, &errs[EE]);
+        }
+        if (numErrs > MAX_ERRS)
+        {
+            fprintf(stderr, "%s: %d more errors\n", argv[FF], numErrs - MAX_ERRS);
+        }
+        numBad     += !!numErrs;
+        free(kvin);
+    }
+
+    kvinFreeSchema(&schema);
+    free(rules);
+    return !!numBad;
+}
+
 int main(int argc, char *argv[])
 {
+    if ((argc > 1) && (strcmp(argv[1], "validate") == 0))
+    {
+        return validateMain(argc - 2, argv + 2);
+    }
+    if ((argc > 1) && (strcmp(argv[1], "tojson") == 0))
+    {
+        return toJsonMain(argc - 2, argv + 2);
+    }
+    if ((argc > 1) && (strcmp(argv[1], "fromjson") == 0))
+    {
+        return fromJsonMain(argc - 2, argv + 2);
+    }
+    if ((argc > 1) && (strcmp(argv[1], "diff") == 0))
+    {
+        return diffMain(argc - 2, argv + 2);
+    }
+    if ((argc > 1) && (strcmp(argv[1], "check") == 0))
+    {
+        return checkMain(argc - 2, argv + 2);
+    }
+
     static const TEST EXS[] =
     {
         { KVIN_PAR_DONE,    "bar        = \"baz\"" },
@@ -162,7 +723,7 @@ int main(int argc, char *argv[])
     int numPassed       = 0;
     int numFailed       = 0;
 
-    for (int EE = 0; EE < (int)sizeof(EXS)/sizeof(EXS[0]); ++EE)
+    for (int EE = 0; EE < (int)(sizeof(EXS)/sizeof(EXS[0])); ++EE)
     {
         KVINParser parser   = { };
         kvinInitParser(&parser, EXS[EE].kvin, EXS[EE].kvin + (int)strlen(EXS[EE].kvin));
@@ -211,7 +772,7 @@ int main(int argc, char *argv[])
         numFailed       += !!(parser.state != EXS[EE].state);
     }
 
-    for (int EE = 0; EE < (int)sizeof(EXS)/sizeof(EXS[0]); ++EE)
+    for (int EE = 0; EE < (int)(sizeof(EXS)/sizeof(EXS[0])); ++EE)
     {
         KVINActor actor     = { };
         MyKVIN myKvin       = { };
@@ -234,12 +795,402 @@ int main(int argc, char *argv[])
         numFailed       += !!(actor.parser.state != EXS[EE].state);
     }
 
+    for (int EE = 0; EE < (int)(sizeof(EXS)/sizeof(EXS[0])); ++EE)
+    {
+        const char* kvin    = EXS[EE].kvin;
+        int numErrs         = kvinValidate(kvin, kvin + strlen(kvin), 0, 0);
+        KVIN_PARSES state   = numErrs ? KVIN_PAR_ERROR : KVIN_PAR_DONE;
+        numExpPassed    += !!(EXS[EE].state == KVIN_PAR_DONE);
+        numExpFailed    += !!(EXS[EE].state == KVIN_PAR_ERROR);
+        numPassed       += !!(state == EXS[EE].state);
+        numFailed       += !!(state != EXS[EE].state);
+    }
+
+    static const PATHTEST PATHS[] =
+    {
+        { "fooddd.bar.baz.bob = 10\n"
+          "    ...quux        = 12\n"
+          "      .dob.baz.bob = 13\n",     "fooddd.bar.baz.bob;fooddd.quux;fooddd.dob.baz.bob;" },
+
+        { "foo.12 = A\n"
+          "   .#  = B\n"
+          "   .#  = C\n",                  "foo.12;foo.13;foo.14;" },
+
+        { "foo.zuul[0]    = 1000\n"
+          "       .[1]    = 102\n"
+          "       .lives  = 3005\n"
+          "[2][0]         = 1\n"
+          "   .#          = 2\n",          "foo.zuul.0;foo.zuul.1;foo.zuul.lives;2.0;2.1;" },
+
+        { "// Two lines\n"
+          "a.b = \"x\n\\\"y\"\n"
+          "\n"
+          " .c = 1 // one\n",               "a.b;a.c;" },
+    };
+
+    // A validateOnly parser leaves integer axes for kvinPathApply to convert.
+    for (int EE = 0; EE < 2 * (int)(sizeof(PATHS)/sizeof(PATHS[0])); ++EE)
+    {
+        char paths[256];
+        int passed          = resolvePaths(PATHS[EE / 2].kvin, EE % 2, paths, sizeof(paths)) && (strcmp(paths, PATHS[EE / 2].paths) == 0);
+        fprintf(stdout, "    %s\n    paths %s\n", paths, passed ? "passed" : "failed");
+        numExpPassed    += 1;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
+    static const DOCTEST DOCS[] =
+    {
+        { "t[0] = 1\n"
+          " .#  = 2\n"
+          " .#  = 3\n",        KVIN_VAL_INTEGER,   0,  3,  { 1, 2, 3 } },
+
+        { "t.5  = 1.5\n"
+          " .#  = 2.5\n",      KVIN_VAL_REAL,      5,  2,  { 1.5, 2.5 } },
+
+        { "t[0] = 1\n"
+          " .#  = 2\n"
+          "t[0] = 7\n",        KVIN_VAL_NONE,      0,  2,  { } },
+
+        { "t[0] = 1\n"
+          " .#  = 2\n"
+          "t[3] = 4\n",        KVIN_VAL_NONE,      0,  3,  { } },
+
+        { "t[0] = 1\n"
+          "t[1] = 2\n"
+          "t[3] = 4\n",        KVIN_VAL_NONE,      0,  3,  { } },
+
+        { "t[0] = 1\n"
+          " .#  = 2.5\n",      KVIN_VAL_NONE,      0,  2,  { } },
+
+        { "t[0] = 1\n"
+          " .#  = 2\n"
+          "t[1].a = 3\n",      KVIN_VAL_NONE,      0,  2,  { } },
+    };
+
+    for (int EE = 0; EE < (int)(sizeof(DOCS)/sizeof(DOCS[0])); ++EE)
+    {
+        int passed          = checkDoc(&DOCS[EE]);
+        fprintf(stdout, "%s    doc %s\n", DOCS[EE].kvin, passed ? "passed" : "failed");
+        numExpPassed    += 1;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
+    {
+        static const char PACKED[] = "t[0] = 0.1\n"
+                                     " .#  = 1e-4000\n"
+                                     " .#  = 2.5\n"
+                                     "u.a  = 0.1\n"
+                                     " .b  = 1e-4000\n"
+                                     " .c  = 2.5\n";
+        int passed          = checkPackedReals(PACKED);
+        fprintf(stdout, "%s    packed reals %s\n", PACKED, passed ? "passed" : "failed");
+        numExpPassed    += 1;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
+    {
+        int passed          = checkLongReal();
+        fprintf(stdout, "    long real at the end of the input %s\n", passed ? "passed" : "failed");
+        numExpPassed    += 1;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
+    // Long reals are shortened on the stack, not copied to the heap.
+    static const LONGREALTEST LONGREALS[] =
+    {
+        { "",               "9",            150,    "e-200"     },
+        { "0.",             "0",            140,    "123e5"     },
+        { "-",              "1234567890",   14,     ".0987654321e+4000" },
+        { "0x",             "f",            130,    "p-3"       },
+        { "0x0.",           "0",            130,    "1p+7"      },
+        { "1",              "0",            200,    ""          },
+    };
+    for (int EE = 0; EE < (int)(sizeof(LONGREALS)/sizeof(LONGREALS[0])); ++EE)
+    {
+        int passed          = checkShortenedReal(&LONGREALS[EE]);
+        fprintf(stdout, "    %s%s x %d %s\n    long real %s\n", LONGREALS[EE].head, LONGREALS[EE].fill, LONGREALS[EE].count, LONGREALS[EE].tail, passed ? "passed" : "failed");
+        numExpPassed    += 1;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
+    static const DIFFTEST DIFFS[] =
+    {
+        { "a.b.c = 1\n"
+          "   ..d = 2\n",
+          "a.b.c = 1\n"
+          "a.d   = 2\n",                   1 << 20,    "" },
+
+        { "l[0] = x\n"
+          " .#  = y\n"
+          " .#  = z\n"
+          "n    = 10\n"
+          "r    = 1.0\n",
+          "n    = 0xA\n"
+          "r    = 1.5\n"
+          "l[2] = w\n"
+          "l[0] = x\n"
+          "m    = \"new\"\n",             1 << 20,    "- l[1] = y\n"
+                                                        "~ l[2] = z -> w\n"
+                                                        "+ m = \"new\"\n"
+                                                        "~ r = 1.0 -> 1.5\n" },
+
+        // Overwrites: a value replaces what was under it, and is replaced by
+        // anything assigned under it later.
+        { "a.b = 1\n"
+          "a   = 2\n"
+          "c   = 3\n"
+          "c.d = 4\n",
+          "a   = 2\n"
+          "c.d = 4\n",                     1 << 20,    "" },
+
+        { "k[3] = 1\nk[1] = 2\nk[2] = 3\nk.x = 4\nk[0] = 5\nk[1] = 6\n",
+          "k[0] = 5\nk[1] = 6\nk[2] = 3\nk[3] = 1\nk.x = 7\n",
+                                            256,        "~ k.x = 4 -> 7\n" },
+    };
+
+    for (int EE = 0; EE < (int)(sizeof(DIFFS)/sizeof(DIFFS[0])); ++EE)
+    {
+        char diff[256];
+        int numDiffs        = diffText(&DIFFS[EE], diff, sizeof(diff));
+        int passed          = (numDiffs >= 0) && (strcmp(diff, DIFFS[EE].diff) == 0);
+        fprintf(stdout, "%s    diff %s\n", diff, passed ? "passed" : "failed");
+        numExpPassed    += 1;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
+    // Hundreds of runs, merged in more than one pass, with the overwrite of
+    // v[7] in the last of them.
+    {
+        static char older[32768];
+        static char newer[32768];
+        int         oldLen  = 0;
+        int         newLen  = 0;
+        for (int II = 0; II < 1000; ++II)
+        {
+            oldLen         += snprintf(older + oldLen, sizeof(older) - oldLen, "v[%d] = %d\n", 999 - II, 999 - II);
+            newLen         += snprintf(newer + newLen, sizeof(newer) - newLen, "v[%d] = %d\n", II, (II == 7) ? 0 : II + (II == 123));
+        }
+        snprintf(older + oldLen, sizeof(older) - oldLen, "v[7] = 0\n");
+        DIFFTEST    test    = { older, newer, 256, "~ v[123] = 123 -> 124\n" };
+        char        diff[256];
+        int numDiffs        = diffText(&test, diff, sizeof(diff));
+        int passed          = (numDiffs == 1) && (strcmp(diff, test.diff) == 0);
+        fprintf(stdout, "%s    diff of many runs %s\n", diff, passed ? "passed" : "failed");
+        numExpPassed    += 1;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
+    static const JSONTEST JSONS[] =
+    {
+        { 1,    "a.b.c  = 1\n"
+                "   ..d = x\n"
+                "e      = 2.5\n",               "{\"a\":{\"b\":{\"c\":1},\"d\":\"x\"},\"e\":2.5}",              0 },
+
+        { 1,    "l[0] = 1\n"
+                " .#  = 2\n"
+                " .#  = 3\n",                   "{\"l\":[1,2,3]}",                                    0 },
+
+        // Sparse indices: nulls fill the holes, sorted or not.
+        { 1,    "s[1] = a\n"
+                "s[4] = b\n",                   "{\"s\":[null,\"a\",null,null,\"b\"]}",                0 },
+
+        { 1,    "s[3] = a\n"
+                "s[1] = b\n",                   "{\"s\":[null,\"b\",null,\"a\"]}",                     0 },
+
+        { 1,    "s = \"a\\tb\\\"c\\x41\\\\\"\n",    "{\"s\":\"a\\tb\\\"cA\\\\\"}",                        0 },
+
+        { 1,    "n = -5\n"
+                "m = 18446744073709551615\n",   "{\"n\":-5,\"m\":1.8446744073709552e+19}",           0 },
+
+        // Streamed, then found to be unsorted: the streamed part is taken back.
+        { 1,    "a = 1\n"
+                "c = 2\n"
+                "b = 3\n",                      "{\"a\":1,\"c\":2,\"b\":3}",                         0 },
+
+        { 0,    "{\"a\":{\"b\":1,\"c\":[1,2]},\"d\":\"x y\"}",
+                                                "a.b = 1\n"
+                                                ".c[0] = 1\n"
+                                                ".# = 2\n"
+                                                "d = \"x y\"\n",                                    1 },
+
+        { 0,    "{\"n\":-5,\"r\":-1.5,\"big\":9223372036854775808}",
+                                                "n = -5\n"
+                                                "r = -1.5\n"
+                                                "big = 9223372036854775808.0\n",                    0 },
+
+        { 0,    "{\"s\":\"a\\tb\\\"c\",\"n\":-9223372036854775808}",
+                                                "s = \"a\\tb\\\"c\"\n"
+                                                "n = -9223372036854775808\n",                      1 },
+
+        // KVIN has no empty objects or arrays: they are dropped, with a warning.
+        { 0,    "{\"e\":{},\"f\":[],\"g\":1}",      "g = 1\n",                                          0 },
+    };
+
+    for (int EE = 0; EE < (int)(sizeof(JSONS)/sizeof(JSONS[0])); ++EE)
+    {
+        char converted[256];
+        char back[256];
+        int passed          = convertText(JSONS[EE].toJson, JSONS[EE].from, converted, sizeof(converted))
+                           && (strcmp(converted, JSONS[EE].to) == 0);
+        if (passed && JSONS[EE].roundTrip)
+        {
+            passed          = convertText(!JSONS[EE].toJson, converted, back, sizeof(back))
+                           && (strcmp(back, JSONS[EE].from) == 0);
+        }
+        fprintf(stdout, "%s\n    %s %s\n", converted, JSONS[EE].toJson ? "tojson" : "fromjson", passed ? "passed" : "failed");
+        numExpPassed    += 1;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
+    static const char   SCHEMA[] =
+        "rule[0].path       = \"server\"\n"
+        "       .required   = 1\n"
+        "  ..#.path         = \"server.host\"\n"
+        "       .type       = identifier\n"
+        "       .required   = 1\n"
+        "  ..#.path         = \"server.port\"\n"
+        "       .type       = integer\n"
+        "       .min        = 1\n"
+        "       .max        = 65535\n"
+        "       .required   = 1\n"
+        "  ..#.path         = \"workers[*].name\"\n"
+        "       .type       = bstring\n"
+        "       .required   = 1\n"
+        "  ..#.path         = \"workers[*].weight\"\n"
+        "       .type       = number\n"
+        "       .min        = 0\n"
+        "  ..#.path         = \"env\"\n"
+        "       .open       = 1\n"
+        "  ..#.path         = \"tags.*\"\n"
+        "       .type       = identifier\n";
+
+    static const SCHEMATEST SCHEMAS[] =
+    {
+        { SCHEMA,   "server.host        = localhost\n"
+                    "      .port        = 8080\n"
+                    "workers[0].name    = \"a\"\n"
+                    "       ..#.name    = \"b\"\n"
+                    "         .weight   = 2.5\n"
+                    "env.ANY.depth[3]   = 1\n"
+                    "tags.x             = y\n"
+                    "tags[7]            = z\n",     0, { } },
+
+        { SCHEMA,   "server.host        = \"localhost\"\n"
+                    "      .port        = 70000\n"
+                    "      .prot        = 1\n"
+                    "workers[0].weight  = -1\n"
+                    "      ..#.name     = \"b\"\n", 5,
+            {   { KVIN_SCH_TYPE,    1, 22 },
+                { KVIN_SCH_RANGE,   2, 22 },
+                { KVIN_SCH_UNKNOWN, 3,  8 },
+                { KVIN_SCH_RANGE,   4, 22 },
+                { KVIN_SCH_MISSING, 4,  8 } } },
+
+        { SCHEMA,   "env.x = 1\n"
+                    "tags.t = 2\n"
+                    "server = 3\n"
+                    "server.host = h\n", 2,
+            {   { KVIN_SCH_TYPE,    2,  10 },
+                { KVIN_SCH_MISSING, 3,  1 } } },
+
+        { SCHEMA,   "server.x = 1\n", 3,
+            {   { KVIN_SCH_UNKNOWN, 1,  8 },
+                { KVIN_SCH_MISSING, 1,  1 },
+                { KVIN_SCH_MISSING, 1,  1 } } },
+
+        { SCHEMA,   "[0] = 1\n", 2,
+            {   { KVIN_SCH_UNKNOWN, 1,  1 },
+                { KVIN_SCH_MISSING, 0,  0 } } },
+
+        { SCHEMA,   "server.host = \n"
+                    "nope = 1\n", 1,
+            {   { KVIN_SCH_SYNTAX,  1, 15 } } },
+
+        { "rule[0].path = \"a..b\"\n",                  0, 1,
+            {   { KVIN_SCH_RULE,    1,  9 } } },
+
+        { "rule[0].path = \"a\"\n"
+          "       .type = string\n",                      0, 1,
+            {   { KVIN_SCH_RULE,    2,  9 } } },
+    };
+
+    for (int EE = 0; EE < (int)(sizeof(SCHEMAS)/sizeof(SCHEMAS[0])); ++EE)
+    {
+        KVINSchemaError errs[6] = { };
+        int numErrs         = checkSchema(&SCHEMAS[EE], errs, 6);
+        int passed          = (numErrs == SCHEMAS[EE].numErrs);
+        for (int RR = 0; passed && (RR < numErrs); ++RR)
+        {
+            passed          = (errs[RR].kind   == SCHEMAS[EE].errs[RR].kind)
+                           && (errs[RR].lineNo == SCHEMAS[EE].errs[RR].lineNo)
+                           && (errs[RR].column == SCHEMAS[EE].errs[RR].column);
+            fprintf(stdout, "    %d:%d: %s\n", errs[RR].lineNo, errs[RR].column, sSCHEMA[errs[RR].kind]);
+        }
+        fprintf(stdout, "    schema %s\n", passed ? "passed" : "failed");
+        numExpPassed    += !SCHEMAS[EE].numErrs;
+        numExpFailed    += !!SCHEMAS[EE].numErrs;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
+    static const ERRTEST ERRS[] =
+    {
+        { "foo = 10\n"
+          "bar = = 10\n"
+          "baz = 12\n"
+          "  .# = 12.5e\n"
+          "bob = \"a\nb\" @\n"
+          "quux =", 4,
+            {   { 2, 7, KVIN_PAR_ASSIGN,    KVIN_LEX_EQUALS,    0 },
+                { 4, 8, KVIN_PAR_ASSIGN,    KVIN_LEX_NUMBERLIKE,0 },
+                { 6, 4, KVIN_PAR_EOL,       KVIN_LEX_UNKNOWN,   0 },
+                { 7, 7, KVIN_PAR_ASSIGN,    KVIN_LEX_EOL,       0 } } },
+
+        { "a = 1 / 2\n"
+          "b = \"unterminated\n", 2,
+            {   { 1, 7, KVIN_PAR_EOL,       KVIN_LEX_UNKNOWN,   0 },
+                { 2, 5, KVIN_PAR_ASSIGN,    KVIN_LEX_UNKNOWN,   0 } } },
+
+        // A backslash as the last byte escapes nothing.
+        { "a = \"x\\", 1,
+            {   { 1, 5, KVIN_PAR_ASSIGN,    KVIN_LEX_UNKNOWN,   0 } } },
+    };
+
+    for (int EE = 0; EE < (int)(sizeof(ERRS)/sizeof(ERRS[0])); ++EE)
+    {
+        KVINError errs[4]   = { };
+        const char* kvin    = ERRS[EE].kvin;
+        int numErrs         = kvinValidate(kvin, kvin + strlen(kvin), errs, 4);
+        int passed          = (numErrs == ERRS[EE].numErrs);
+        for (int RR = 0; passed && (RR < numErrs); ++RR)
+        {
+            passed          = (errs[RR].lineNo == ERRS[EE].errs[RR].lineNo)
+                           && (errs[RR].column == ERRS[EE].errs[RR].column)
+                           && (errs[RR].state  == ERRS[EE].errs[RR].state)
+                           && (errs[RR].lex    == ERRS[EE].errs[RR].lex);
+            fprintf(stdout, "    %d:%d: unexpected %s in %s\n",
+                errs[RR].lineNo, errs[RR].column, sLEXEME[errs[RR].lex], sPARSES[errs[RR].state]);
+        }
+        fprintf(stdout, "    validate %s\n", passed ? "passed" : "failed");
+        numExpFailed    += 1;
+        numPassed       += !!passed;
+        numFailed       += !passed;
+    }
+
     fprintf(stdout,
         "ROLLUP: exp. passed exp. failed passed failed\n"
         "        %-11d %-11d %-6d %-6d\n",
         numExpPassed, numExpFailed, numPassed, numFailed);
 
-    return !!!numFailed;
+    return !!numFailed;
 }
 
 #define REKVIN_C
@@ -1,6 +1,8 @@
 #ifndef REKVIN_H
 #define REKVIN_H
 
+#include <stddef.h>
+
 #ifdef  __cplusplus
 extern "C" {
 #endif//__cplusplus
@@ -43,7 +45,8 @@ extern "C" {
     X(INTEGER)                  \
     X(REAL)                     \
     X(BSTRING)                  \
-    X(NONE)
+    X(NONE)                     \
+    X(UNCONVERTED)
 
 typedef enum KVIN_LEXEME
 {
@@ -99,7 +102,7 @@ typedef struct KVINValue
 typedef struct KVINLexer
 {
     KVIN_LEXEME     lex;
-    int             lineNo;
+    int             lineNo;         // Newlines passed so far: 0-based line of lend.
     const char*     begin;
     const char*     lbeg;
     const char*     lend;
@@ -112,8 +115,23 @@ typedef struct KVINParser
     KVIN_ACTION     action;
     KVINLexer       lexer;
     KVINValue       value;
+    int             validateOnly;   // Check values, but do not convert them:
+                                    // values have integer/real zeroed, and
+                                    // integer axes are UNCONVERTED, with their
+                                    // lexeme in begin/end for kvinPathApply.
 } KVINParser;
 
+// A syntax error found by kvinValidate. Line and column are 1-based, and are
+// only computed (by counting newlines) once an error has been found.
+typedef struct KVINError
+{
+    int             lineNo;
+    int             column;
+    KVIN_PARSES     state;          // The parse state the lexeme was rejected in.
+    KVIN_LEXEME     lex;            // The rejected lexeme.
+    const char*     at;
+} KVINError;
+
 typedef int   (*kvinSetAtRootFptr)      (void* handle, KVINValue);
 typedef int   (*kvinSetNextAxisFptr)    (void* handle, KVINValue);
 typedef int   (*kvinRelPathFptr)        (void* handle);
@@ -135,12 +153,222 @@ typedef struct KVINActor
     kvinDoneFptr            Done;
 } KVINActor;
 
+// The absolute path named by the parser's path actions. Axes are INTEGER or
+// IDENTIFIER values (pointing into the parsed text), kept in caller-provided
+// storage. `#` numbers on from the integer axis it replaces, or from 0.
+typedef struct KVINPath
+{
+    KVINValue      *axes;
+    int             depth;
+    int             capacity;
+    KVINValue       popped;
+} KVINPath;
+
+// The document layer: a tree of nodes in one array, linked in insertion
+// order. Children are found through a single hash table keyed by (parent uid,
+// axis); an overwritten node gets a new uid, orphaning its old children.
+//
+// Runs of consecutive integer axes holding only INTEGER (or only REAL)
+// values, as written by `.#` or `[N]`, are not nodes at all: they are packed
+// into a KVINColumn on their container, reals as plain doubles so a column is
+// an array that vector code can use directly. Packing rounds a real to double,
+// and a spilled value stays rounded. Anything else arriving at that container
+// (a gap, another type, an identifier, a subtree, an overwrite) first spills
+// the column back into nodes.
+typedef void* (*kvinReallocFptr)(void* handle, void* ptr, size_t size);
+
+typedef struct KVINColumn
+{
+    KVIN_VALUE              type;       // INTEGER or REAL.
+    unsigned long long      base;       // The axis of the first element.
+    size_t                  length;
+    size_t                  capacity;
+    union
+    {
+        unsigned long long *integers;
+        double             *reals;
+        void               *data;
+    };
+} KVINColumn;
+
+typedef struct KVINDocNode
+{
+    KVINValue               key;
+    KVINValue               value;      // NONE for objects and arrays.
+    int                     uid;
+    int                     parent;
+    int                     parentUid;
+    int                     first;
+    int                     last;
+    int                     next;
+    int                     numChildren;
+    int                     numInts;
+    unsigned long long      maxIndex;
+    int                     column;     // Index into columns, or -1.
+} KVINDocNode;
+
+typedef struct KVINDoc
+{
+    KVINDocNode            *nodes;
+    int                     numNodes;
+    int                     capNodes;
+    KVINColumn             *columns;
+    int                     numColumns;
+    int                     capColumns;
+    int                    *table;
+    size_t                  mask;
+    int                     nextUid;
+    int                    *nodeAt;     // The node each axis of the current path lives in.
+    int                     capNodeAt;
+    kvinReallocFptr         Realloc;
+    void                   *handle;
+} KVINDoc;
+
+// The schema layer. A schema is itself KVIN: a list of rules, each naming a
+// path and what may be assigned there,
+//
+//      rule[0].path     = "server.port"
+//             .type     = integer      // integer, real, number, identifier, bstring or any
+//             .min      = 1            // Integers compare as signed.
+//             .max      = 65535
+//             .required = 1            // Wherever its parent is.
+//
+// which compile into a trie of nodes, one for each path prefix. In a path,
+// `[*]` matches any integer axis and `*` any axis at all. Children are found
+// through one table keyed by (node, axis), with identifiers interned, so each
+// axis the parser sets costs a hash of its text and a probe or two. Anything
+// the schema does not name is unknown, unless it is below an `open = 1` rule.
+#define KVIN_SCHEMA_ERROR_TABLE(X)  \
+    X(SYNTAX)                   \
+    X(DEPTH)                    \
+    X(RULE)                     \
+    X(TYPE)                     \
+    X(RANGE)                    \
+    X(UNKNOWN)                  \
+    X(MISSING)
+
+typedef enum KVIN_SCHEMA_ERROR
+{
+#undef  KVIN_SCHEMA_ERROR_ENTRY
+#define KVIN_SCHEMA_ERROR_ENTRY(NAME) KVIN_SCH_ ## NAME,
+KVIN_SCHEMA_ERROR_TABLE(KVIN_SCHEMA_ERROR_ENTRY)
+#undef  KVIN_SCHEMA_ERROR_ENTRY
+    KVIN_SCH_MAX,
+} KVIN_SCHEMA_ERROR;
+
+#define KVIN_SCHEMA_UNKNOWN     (-1)    // A path the schema does not name.
+#define KVIN_SCHEMA_OPEN        (-2)    // A path below an `open = 1` rule.
+
+typedef struct KVINSchemaNode
+{
+    KVINValue               key;        // INTEGER or IDENTIFIER; NONE for `[*]` and `*`.
+    int                     name;       // The interned identifier, or -1.
+    int                     parent;
+    int                     types;      // A (1 << KVIN_VAL_x) bit for each type a value may have.
+    int                     required;
+    int                     open;
+    KVINValue               min;        // INTEGER, REAL or NONE.
+    KVINValue               max;
+    int                     anyIndex;   // The `[*]` child, or -1.
+    int                     anyAxis;    // The `*` child, or -1.
+    int                     bit;        // In the parent's requiredMask, or -1.
+    unsigned long long      requiredMask;
+    int                     requiredAt; // Its 64 required children, by bit, in requiredChild; or -1.
+} KVINSchemaNode;
+
+typedef struct KVINSchema
+{
+    KVINSchemaNode         *nodes;      // The root is node 0.
+    int                     numNodes;
+    int                     capNodes;
+    KVINValue              *names;      // Interned identifiers, pointing into the schema's text.
+    int                     numNames;
+    int                     capNames;
+    int                    *nameTable;
+    size_t                  nameMask;
+    int                    *edgeTable;  // Nodes, by (parent, axis).
+    size_t                  edgeMask;
+    int                    *requiredChild;
+    int                     numRequired;
+    int                     capRequired;
+    kvinReallocFptr         Realloc;
+    void                   *handle;
+} KVINSchema;
+
+// A rule broken by the checked text (or, for SYNTAX, DEPTH and RULE from
+// kvinSchemaLoad, by the schema's). Keys missing from the root have no line.
+typedef struct KVINSchemaError
+{
+    KVIN_SCHEMA_ERROR       kind;
+    int                     lineNo;
+    int                     column;
+    int                     node;       // The rule; for UNKNOWN, the last node matched.
+    KVINValue               value;      // The value breaking it; for UNKNOWN, the axis.
+    const char*             at;
+} KVINSchemaError;
+
+// Each place a node with required children was seen, and which it has had.
+typedef struct KVINSchemaSeen
+{
+    int                     node;
+    int                     keys;       // Its `[*]` and `*` axes, in KVINSchemaCheck.keys.
+    int                     numKeys;
+    unsigned long long      found;
+    size_t                  hash;
+    const char*             at;
+} KVINSchemaSeen;
+
+typedef struct KVINSchemaCheck
+{
+    const KVINSchema       *schema;
+    int                    *nodeAt;     // The node each axis of the current path matched.
+    int                    *seenAt;     // Its KVINSchemaSeen, or -1.
+    int                     capacity;
+    KVINSchemaSeen         *seen;
+    int                     numSeen;
+    int                     capSeen;
+    int                    *seenTable;
+    size_t                  seenMask;
+    KVINValue              *keys;
+    int                     numKeys;
+    int                     capKeys;
+    KVINSchemaError        *errs;
+    int                     maxErrs;
+    int                     numErrs;
+    const char*             fst;
+    const char*             lineAt;
+    const char*             lineBeg;
+    int                     lineNo;
+} KVINSchemaCheck;
+
 int kvinInitLex(KVINLexer* lex, const char* fst, const char* lst);
 int kvinLexNext(KVINLexer*);
 int kvinInitParser(KVINParser* prs, const char* fst, const char* lst);
 int kvinParseNext(KVINParser*);
 int kvinParseNextCB(KVINActor*);
 int kvinParse(KVINActor*);
+int kvinValidate(const char* fst, const char* lst, KVINError* errs, int maxErrs);
+int kvinLocate(const char* fst, const char* at, int* lineNo, int* column);
+int kvinUnescape(const char** cur, const char* end);
+int kvinInitPath(KVINPath* path, KVINValue* axes, int capacity);
+int kvinPathApply(KVINPath* path, const KVINParser* prs);
+int kvinCompareAxis(const KVINValue* lhs, const KVINValue* rhs);
+int kvinInitDoc(KVINDoc* doc, kvinReallocFptr Realloc, void* handle);
+int kvinDocLoad(KVINDoc* doc, KVINParser* prs, KVINPath* path);
+int kvinDocFind(const KVINDoc* doc, int node, const KVINValue* key);
+const KVINColumn* kvinDocColumn(const KVINDoc* doc, int node);
+void kvinFreeDoc(KVINDoc* doc);
+int kvinInitSchema(KVINSchema* schema, kvinReallocFptr Realloc, void* handle);
+int kvinSchemaLoad(KVINSchema* schema, const char* fst, const char* lst, KVINSchemaError* err);
+void kvinFreeSchema(KVINSchema* schema);
+int kvinInitSchemaCheck(KVINSchemaCheck* chk, const KVINSchema* schema, const char* fst, int capacity, KVINSchemaError* errs, int maxErrs);
+int kvinSchemaApply(KVINSchemaCheck* chk, const KVINPath* path, const KVINParser* prs);
+int kvinSchemaFinish(KVINSchemaCheck* chk);
+void kvinFreeSchemaCheck(KVINSchemaCheck* chk);
+int kvinSchemaValidate(const KVINSchema* schema, const char* fst, const char* lst, KVINSchemaError* errs, int maxErrs);
+#ifndef REKVIN_NO_STDLIB
+void* kvinStdRealloc(void* handle, void* ptr, size_t size);
+#endif//REKVIN_NO_STDLIB
 
 #ifdef  __cplusplus
 } // extern "C".
@@ -151,9 +379,8 @@ int kvinParse(KVINActor*);
 #ifdef  REKVIN_C
 
 #ifndef REKVIN_NO_STDLIB
-
-#include <ctype.h>
 #include <stdlib.h>
+#endif//REKVIN_NO_STDLIB
 
 #ifdef  __cplusplus
 extern "C" {
@@ -163,52 +390,390 @@ extern "C" {
 #define kvin_assert(MSG) if (!(MSG)) { return 0; }
 #endif//kvin_assert
 
-static int kvin_isspace(const char c)
+// Character classes, for the "C" locale. A table instead of <ctype.h>: it
+// needs no libc, and does not call through the locale for every byte.
+enum KVIN_CHARCLASS
 {
-    return isspace(c);
-}
+    KVIN_CS = 0x01,     // isspace
+    KVIN_CA = 0x02,     // isalpha
+    KVIN_CD = 0x04,     // isdigit
+    KVIN_CU = 0x08,     // '_'
+    KVIN_CP = 0x10,     // '.', '-' and '+', which may appear in numbers
+    KVIN_CX = 0x20,     // isxdigit
+};
+
+static const unsigned char kvinCharClass[256] =
+{
+    /* 0_ */  0              , 0              , 0              , 0              , 0              , 0              , 0              , 0              , 0              , KVIN_CS        , KVIN_CS        , KVIN_CS        , KVIN_CS        , KVIN_CS        , 0              , 0,
+    /* 1_ */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 2_ */  KVIN_CS        , 0              , 0              , 0              , 0              , 0              , 0              , 0              , 0              , 0              , 0              , KVIN_CP        , 0              , KVIN_CP        , KVIN_CP        , 0,
+    /* 3_ */  KVIN_CD|KVIN_CX, KVIN_CD|KVIN_CX, KVIN_CD|KVIN_CX, KVIN_CD|KVIN_CX, KVIN_CD|KVIN_CX, KVIN_CD|KVIN_CX, KVIN_CD|KVIN_CX, KVIN_CD|KVIN_CX, KVIN_CD|KVIN_CX, KVIN_CD|KVIN_CX, 0              , 0              , 0              , 0              , 0              , 0,
+    /* 4_ */  0              , KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA,
+    /* 5_ */  KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , 0              , 0              , 0              , 0              , KVIN_CU,
+    /* 6_ */  0              , KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA|KVIN_CX, KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA,
+    /* 7_ */  KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , KVIN_CA        , 0              , 0              , 0              , 0              , 0,
+    /* 8_ */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 9_ */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* A_ */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* B_ */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* C_ */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* D_ */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* E_ */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* F_ */  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
 
-static int kvin_isalpha(const char c)
+static int kvin_isspace(const char c)
 {
-    return isalpha(c);
+    return kvinCharClass[(unsigned char)c] & KVIN_CS;
 }
 
 static int kvin_isdigit(const char c)
 {
-    return isdigit(c);
+    return kvinCharClass[(unsigned char)c] & KVIN_CD;
 }
 
-#else// REKVIN_NO_STDLIB
-
-// XXX: You've got a lot of definin' to do.
-
-#endif//REKVIN_NO_STDLIB
+static int kvin_isxdigit(const char c)
+{
+    return kvinCharClass[(unsigned char)c] & KVIN_CX;
+}
 
 static int kvin_iscid(const char c)
 {
-    return kvin_isalpha(c) || (c == '_');
+    return kvinCharClass[(unsigned char)c] & (KVIN_CA | KVIN_CU);
 }
 
 static int kvin_iscidn(const char c)
 {
-    return kvin_iscid(c) || kvin_isdigit(c);
+    return kvinCharClass[(unsigned char)c] & (KVIN_CA | KVIN_CU | KVIN_CD);
 }
 
 static int kvin_iscidnd(const char c)
 {
-    return kvin_iscidn(c) || (c == '.') || (c == '-') || (c == '+');
+    return kvinCharClass[(unsigned char)c] & (KVIN_CA | KVIN_CU | KVIN_CD | KVIN_CP);
+}
+
+static int kvin_digitval(const char c)
+{
+    return kvin_isdigit(c) ? (c - '0') : ((c | 0x20) - 'a' + 10);
+}
+
+// strtoull(str, &last, 0), but bounded by end: an optional sign, then a hex,
+// octal or decimal number. "-n" wraps. Overflow gives ULLONG_MAX and leaves
+// *last at beg, as if nothing had been read.
+static unsigned long long kvin_strtoull(const char* beg, const char* end, const char** last)
+{
+    const char*         cur     = beg;
+    int                 neg     = 0;
+    int                 base    = 10;
+    int                 over    = 0;
+    unsigned long long  ull     = 0;
+
+    if ((cur < end) && ((*cur == '+') || (*cur == '-')))
+    {
+        neg                     = (*cur++ == '-');
+    }
+    if (((end - cur) > 2) && (cur[0] == '0') && ((cur[1] | 0x20) == 'x') && kvin_isxdigit(cur[2]))
+    {
+        base                    = 16;
+        cur                    += 2;
+    }
+    else
+    if ((cur < end) && (cur[0] == '0'))
+    {
+        base                    = 8;
+    }
+    const char*         digits  = cur;
+    for (; (cur < end) && ((base == 16) ? kvin_isxdigit(*cur) : (kvin_isdigit(*cur) && (*cur - '0' < base))); ++cur)
+    {
+        unsigned digit          = (unsigned)kvin_digitval(*cur);
+        // Only divide once ull is large enough that it might overflow.
+        over                   |= (ull > (~0ull >> 4)) && (ull > (~0ull - digit) / base);
+        ull                     = ull * base + digit;
+    }
+    *last                       = ((cur == digits) || over) ? beg : cur;
+    if (over)
+    {
+        return ~0ull;
+    }
+    return neg ? (0ull - ull) : ull;
+}
+
+// An INTEGER value is a signed 64-bit number, held as its two's complement in
+// .integer: read it as (long long). Whether ull, which kvin_strtoull read from
+// a lexeme starting at beg, is one; a lexeme that is not is a REAL.
+static int pkvinIsSigned(const char* beg, unsigned long long ull)
+{
+    return (ull == 0) || ((ull >> 63) == (unsigned long long)(*beg == '-'));
+}
+
+#ifndef REKVIN_NO_STDLIB
+
+enum
+{
+    KVIN_REAL_COPY      = 128,  // Lexemes shorter than this are copied as they are.
+    KVIN_REAL_DIGITS    = 40,   // Significant digits kept from longer ones.
+};
+
+// Copies a real lexeme too long for a KVIN_REAL_COPY buffer into buf, as the
+// same number in a few dozen bytes: its first KVIN_REAL_DIGITS significant
+// digits, then a 1 if any dropped digit was not 0 (so it still rounds the
+// same way, in practice), and an exponent that accounts for the dropped ones.
+// Returns 0 if beg to end is not a real.
+static int pkvinShortenReal(const char* beg, const char* end, char* buf)
+{
+    const char* cur             = beg;
+    char*       out             = buf;
+    int         hex             = 0;
+    int         seen            = 0;
+    int         kept            = 0;
+    int         sticky          = 0;
+    long        shift           = 0;
+    long        exp             = 0;
+
+    if ((cur < end) && ((*cur == '+') || (*cur == '-')))
+    {
+        *out++                  = *cur++;
+    }
+    hex                         = ((end - cur) > 1) && (cur[0] == '0') && ((cur[1] | 0x20) == 'x');
+    if (hex)
+    {
+        *out++                  = *cur++;
+        *out++                  = *cur++;
+    }
+    for (int frac = 0; cur < end; ++cur)
+    {
+        if ((*cur == '.') && !frac)
+        {
+            frac                = 1;
+            continue;
+        }
+        if (!(hex ? kvin_isxdigit(*cur) : kvin_isdigit(*cur)))
+        {
+            break;
+        }
+        seen                    = 1;
+        if ((kept == 0) && (*cur == '0'))
+        {
+            shift              -= frac;
+        }
+        else
+        if (kept < KVIN_REAL_DIGITS)
+        {
+            *out++              = *cur;
+            shift              -= frac;
+            ++kept;
+        }
+        else
+        {
+            sticky             |= (*cur != '0');
+            shift              += !frac;
+        }
+    }
+    if (!seen)
+    {
+        return 0;
+    }
+    if (sticky)
+    {
+        *out++                  = '1';
+        --shift;
+    }
+    if (kept == 0)
+    {
+        *out++                  = '0';
+    }
+    if ((cur < end) && ((*cur | 0x20) == (hex ? 'p' : 'e')))
+    {
+        int         expNeg      = 0;
+        ++cur;
+        if ((cur < end) && ((*cur == '+') || (*cur == '-')))
+        {
+            expNeg              = (*cur++ == '-');
+        }
+        if ((cur >= end) || !kvin_isdigit(*cur))
+        {
+            return 0;
+        }
+        for (; (cur < end) && kvin_isdigit(*cur); ++cur)
+        {
+            exp                 = (exp < 1000000) ? (10 * exp + (*cur - '0')) : exp;
+        }
+        exp                     = expNeg ? -exp : exp;
+    }
+    if (cur != end)
+    {
+        return 0;
+    }
+    // A hex exponent is binary, so each hex digit moves it by 4.
+    exp                        += hex ? 4 * shift : shift;
+    *out++                      = hex ? 'p' : 'e';
+    *out++                      = (exp < 0) ? '-' : '+';
+    char        digits[24];
+    int         numDigits       = 0;
+    for (unsigned long mag = (exp < 0) ? (unsigned long)-exp : (unsigned long)exp; mag || !numDigits; mag /= 10)
+    {
+        digits[numDigits++]     = (char)('0' + (mag % 10));
+    }
+    while (numDigits)
+    {
+        *out++                  = digits[--numDigits];
+    }
+    *out                        = 0;
+    return 1;
+}
+
+// The lexeme is not terminated, so strtold reads a copy on the stack, which
+// pkvinShortenReal makes for long ones; nothing is allocated.
+static long double kvin_strtold(const char* beg, const char* end, const char** last)
+{
+    char    buf[KVIN_REAL_COPY];
+    char*   bufEnd  = 0;
+    size_t  len     = (size_t)(end - beg);
+    *last           = beg;
+    if (len >= sizeof(buf))
+    {
+        if (!pkvinShortenReal(beg, end, buf))
+        {
+            return 0;
+        }
+        long double ld  = strtold(buf, &bufEnd);
+        *last           = *bufEnd ? beg : end;
+        return ld;
+    }
+    for (size_t II = 0; II < len; ++II)
+    {
+        buf[II]     = beg[II];
+    }
+    buf[len]        = 0;
+    long double ld  = strtold(buf, &bufEnd);
+    *last           = beg + (bufEnd - buf);
+    return ld;
 }
 
-static int kvin_strtoull(const char* str, char** str_end, int base)
+#else// REKVIN_NO_STDLIB
+
+// b ** e, by squaring.
+static long double pkvinPow(long double b, int e)
 {
-    return strtoull(str, str_end, base);
+    long double result  = 1.0L;
+    for (; e; e >>= 1, b *= b)
+    {
+        if (e & 1)
+        {
+            result     *= b;
+        }
+    }
+    return result;
 }
 
-static long double kvin_strtold(const char* str, char** str_end)
+// strtold without libc, for decimal and hex (0x...p...) reals, inf and nan.
+// The first 19 significant digits are kept exactly and scaled in long
+// double, so the result is within a few ulps of long double: a double read
+// from it is nearly always the correctly rounded one, but not guaranteed to be.
+static long double kvin_strtold(const char* beg, const char* end, const char** last)
 {
-    return strtold(str, str_end);
+    const char*         cur     = beg;
+    int                 neg     = 0;
+    int                 hex     = 0;
+    int                 digits  = 0;
+    int                 scale   = 0;
+    unsigned long long  mant    = 0;
+    long double         ld      = 0;
+
+    *last                       = beg;
+    if ((cur < end) && ((*cur == '+') || (*cur == '-')))
+    {
+        neg                     = (*cur++ == '-');
+    }
+    if (((end - cur) >= 3) && ((cur[0] | 0x20) == 'i') && ((cur[1] | 0x20) == 'n') && ((cur[2] | 0x20) == 'f'))
+    {
+        int infinity            = ((end - cur) >= 8) && ((cur[3] | 0x20) == 'i') && ((cur[4] | 0x20) == 'n')
+                               && ((cur[5] | 0x20) == 'i') && ((cur[6] | 0x20) == 't') && ((cur[7] | 0x20) == 'y');
+        *last                   = cur + (infinity ? 8 : 3);
+        return neg ? -__builtin_infl() : __builtin_infl();
+    }
+    if (((end - cur) >= 3) && ((cur[0] | 0x20) == 'n') && ((cur[1] | 0x20) == 'a') && ((cur[2] | 0x20) == 'n'))
+    {
+        *last                   = cur + 3;
+        return neg ? -__builtin_nanl("") : __builtin_nanl("");
+    }
+
+    hex                         = ((end - cur) > 1) && (cur[0] == '0') && ((cur[1] | 0x20) == 'x');
+    cur                        += hex ? 2 : 0;
+    int     base                = hex ? 16 : 10;
+    int     maxDigits           = hex ? 15 : 19;
+    int     seen                = 0;
+    for (int frac = 0; cur < end; ++cur)
+    {
+        if ((*cur == '.') && !frac)
+        {
+            frac                = 1;
+            continue;
+        }
+        if (!(hex ? kvin_isxdigit(*cur) : kvin_isdigit(*cur)))
+        {
+            break;
+        }
+        seen                    = 1;
+        if ((mant == 0) && (*cur == '0'))
+        {
+            scale              -= frac;
+            continue;
+        }
+        if (digits < maxDigits)
+        {
+            mant                = mant * base + (unsigned)kvin_digitval(*cur);
+            scale              -= frac;
+            ++digits;
+        }
+        else
+        {
+            scale              += !frac;
+        }
+    }
+    if (!seen)
+    {
+        return 0;
+    }
+    *last                       = cur;
+
+    if ((cur < end) && ((*cur | 0x20) == (hex ? 'p' : 'e')))
+    {
+        const char* exp         = cur + 1;
+        int         expNeg      = 0;
+        int         expVal      = 0;
+        if ((exp < end) && ((*exp == '+') || (*exp == '-')))
+        {
+            expNeg              = (*exp++ == '-');
+        }
+        if ((exp < end) && kvin_isdigit(*exp))
+        {
+            for (; (exp < end) && kvin_isdigit(*exp); ++exp)
+            {
+                expVal          = (expVal < 100000) ? (10 * expVal + (*exp - '0')) : expVal;
+            }
+            *last               = exp;
+            if (hex)
+            {
+                // Binary exponent: fold the hex digits' scale into it.
+                scale           = 4 * scale + (expNeg ? -expVal : expVal);
+                ld              = (scale < 0) ? ((long double)mant / pkvinPow(2.0L, -scale)) : ((long double)mant * pkvinPow(2.0L, scale));
+                return neg ? -ld : ld;
+            }
+            scale              += expNeg ? -expVal : expVal;
+        }
+    }
+    if (hex)
+    {
+        scale                  *= 4;
+    }
+    long double b               = hex ? 2.0L : 10.0L;
+    ld                          = (scale < 0) ? ((long double)mant / pkvinPow(b, -scale)) : ((long double)mant * pkvinPow(b, scale));
+    return neg ? -ld : ld;
 }
 
+#endif//REKVIN_NO_STDLIB
+
 int kvinInitLex(KVINLexer* lex, const char* fst, const char* lst)
 {
     kvin_assert(lex);
@@ -267,9 +832,12 @@ int kvinLexNext(KVINLexer* lex)
         if (lex->lend[0] == '/')
         {
             wsLike  = 0;
-            ++lex->lend;
-            kvin_assert(lex->lend < lex->end);
-            kvin_assert(lex->lend[0] == '/');
+            if (((lex->lend + 1) >= lex->end) || (lex->lend[1] != '/'))
+            {
+                // A lone '/' is an UNKNOWN lexeme, not the end of input.
+                lex->lbeg   = lex->lend;
+                return 1;
+            }
             while ((lex->lend < lex->end) && (lex->lend[0] != '\n'))
             {
                 ++lex->lend;
@@ -277,6 +845,11 @@ int kvinLexNext(KVINLexer* lex)
         }
     } while (wsLike);
 
+    if (lex->lend >= lex->end)
+    {
+        return 0;
+    }
+
     lex->lbeg   = lex->lend;
 
 #undef  KVIN_OP
@@ -287,7 +860,7 @@ int kvinLexNext(KVINLexer* lex)
 
     switch (lex->lend[0])
     {
-    case '\n'   : KVIN_OP(EOL);
+    case '\n'   : ++lex->lineNo; KVIN_OP(EOL);
     case '.'    : KVIN_OP(DOT);
     case '='    : KVIN_OP(EQUALS);
     case '#'    : KVIN_OP(HASH);
@@ -297,10 +870,10 @@ int kvinLexNext(KVINLexer* lex)
         ++lex->lend;
         while ((lex->lend < lex->end) && (lex->lend[0] != '"'))
         {
-            if (lex->lend[0] == '\\')
+            // An escape skips the next byte, unless there is none.
+            if ((lex->lend[0] == '\\') && (lex->lend + 1 < lex->end))
             {
                 ++lex->lend;
-                kvin_assert(lex->lend < lex->end);
             }
             if (lex->lend[0] == '\n')
             {
@@ -308,8 +881,12 @@ int kvinLexNext(KVINLexer* lex)
             }
             ++lex->lend;
         }
-        kvin_assert(lex->lend < lex->end);
-        kvin_assert(lex->lend[0] == '"');
+        if (lex->lend >= lex->end)
+        {
+            // Unterminated: leave an UNKNOWN lexeme covering the rest.
+            lex->lend   = lex->end;
+            return 1;
+        }
         ++lex->lend;
         lex->lex    = KVIN_LEX_BSTRING;
         return 1;
@@ -344,23 +921,111 @@ int kvinLexNext(KVINLexer* lex)
 int kvinInitParser(KVINParser* prs, const char* fst, const char* lst)
 {
     kvin_assert(prs);
-    prs->state      = KVIN_PAR_INITIAL;
-    prs->action     = KVIN_ACT_NONE;
+    prs->state          = KVIN_PAR_INITIAL;
+    prs->action         = KVIN_ACT_NONE;
+    prs->validateOnly   = 0;
     return kvinInitLex(&prs->lexer, fst, lst);
 }
 
 typedef int (*KVINParse)    (KVINParser* prs);
 
+static int pkvinMatchNoCase(const char* beg, const char* end, const char* word)
+{
+    for (; *word; ++beg, ++word)
+    {
+        if ((beg >= end) || ((*beg | 0x20) != *word))
+        {
+            return 0;
+        }
+    }
+    return (beg == end);
+}
+
+// Classifies a NUMBERLIKE lexeme the way strtoull (base 0) followed by
+// strtold would, without converting it.
+static KVIN_VALUE pkvinScanNumberLike(const char* beg, const char* end)
+{
+    const char* cur         = beg;
+    if ((cur < end) && ((*cur == '+') || (*cur == '-')))
+    {
+        ++cur;
+    }
+    if (pkvinMatchNoCase(cur, end, "inf")
+     || pkvinMatchNoCase(cur, end, "infinity")
+     || pkvinMatchNoCase(cur, end, "nan"))
+    {
+        return KVIN_VAL_REAL;
+    }
+
+    int hex                 = ((end - cur) > 1) && (cur[0] == '0') && ((cur[1] | 0x20) == 'x');
+    int leadZero            = !hex && (cur < end) && (cur[0] == '0');
+    int octal               = leadZero;
+    int digits              = 0;
+    int isReal              = 0;
+    char expChar            = hex ? 'p' : 'e';
+    cur                    += hex ? 2 : 0;
+
+    for (; (cur < end) && (hex ? kvin_isxdigit(*cur) : kvin_isdigit(*cur)); ++cur, ++digits)
+    {
+        octal              &= (*cur < '8');
+    }
+    if ((cur < end) && (*cur == '.'))
+    {
+        isReal              = 1;
+        for (++cur; (cur < end) && (hex ? kvin_isxdigit(*cur) : kvin_isdigit(*cur)); ++cur, ++digits)
+        {
+        }
+    }
+    if (digits == 0)
+    {
+        return KVIN_VAL_NONE;
+    }
+    if ((cur < end) && ((*cur | 0x20) == expChar))
+    {
+        isReal              = 1;
+        ++cur;
+        if ((cur < end) && ((*cur == '+') || (*cur == '-')))
+        {
+            ++cur;
+        }
+        if ((cur >= end) || !kvin_isdigit(*cur))
+        {
+            return KVIN_VAL_NONE;
+        }
+        while ((cur < end) && kvin_isdigit(*cur))
+        {
+            ++cur;
+        }
+    }
+    if (cur != end)
+    {
+        return KVIN_VAL_NONE;
+    }
+    // "09" is not an octal integer, but strtold accepts it as a real.
+    if (isReal || (leadZero && !octal))
+    {
+        return KVIN_VAL_REAL;
+    }
+    // Only an integer this long can be out of range, and is converted to see.
+    if (digits >= 16)
+    {
+        const char*         last    = 0;
+        unsigned long long  ull     = kvin_strtoull(beg, end, &last);
+        return ((last == end) && pkvinIsSigned(beg, ull)) ? KVIN_VAL_INTEGER : KVIN_VAL_REAL;
+    }
+    return KVIN_VAL_INTEGER;
+}
+
 static KVIN_VALUE pkvinAnalyzeNumberLike(const char* beg, const char* end, unsigned long long* integer, long double* real)
 {
-    char* last              = 0;
-    unsigned long long ull  = kvin_strtoull(beg, &last, 0);
-    if (last == end)
+    const char* last        = 0;
+    unsigned long long ull  = kvin_strtoull(beg, end, &last);
+    if ((last == end) && pkvinIsSigned(beg, ull))
     {
         *integer            = ull;
         return KVIN_VAL_INTEGER;
     }
-    long double ld          = kvin_strtold(beg, &last);
+    long double ld          = kvin_strtold(beg, end, &last);
     if (last == end)
     {
         *real               = ld;
@@ -381,6 +1046,22 @@ static int pkvinDone(KVINParser* prs)
     return 0;
 }
 
+static void pkvinAxisInteger(KVINParser* prs)
+{
+    const char* last        = 0;
+    if (prs->validateOnly)
+    {
+        prs->value.type     = KVIN_VAL_UNCONVERTED;
+        prs->value.begin    = prs->lexer.lbeg;
+        prs->value.end      = prs->lexer.lend;
+    }
+    else
+    {
+        prs->value.type     = KVIN_VAL_INTEGER;
+        prs->value.integer  = kvin_strtoull(prs->lexer.lbeg, prs->lexer.lend, &last);
+    }
+}
+
 static int pkvinCommonPath(KVINParser* prs)
 {
     if (prs->lexer.lex == KVIN_LEX_LBRACKET)
@@ -395,8 +1076,7 @@ static int pkvinCommonPath(KVINParser* prs)
             prs->state  = KVIN_PAR_ERROR;
             return 0;
         }
-        prs->value.type     = KVIN_VAL_INTEGER;
-        prs->value.integer  = kvin_strtoull(prs->lexer.lbeg, 0, 0);
+        pkvinAxisInteger(prs);
         if (!kvinLexNext(&prs->lexer))
         {
             prs->state  = KVIN_PAR_ERROR;
@@ -418,12 +1098,12 @@ static int pkvinCommonPath(KVINParser* prs)
         switch (prs->lexer.lex)
         {
         case KVIN_LEX_IDENTIFIER    :
+            prs->value.type         = KVIN_VAL_IDENTIFIER;
             prs->value.begin        = prs->lexer.lbeg;
             prs->value.end          = prs->lexer.lend;
             break;
         case KVIN_LEX_NUMBERLIKE    :
-            prs->value.type         = KVIN_VAL_INTEGER;
-            prs->value.integer      = kvin_strtoull(prs->lexer.lbeg, 0, 0);
+            pkvinAxisInteger(prs);
             break;
         default                     : break;
         }
@@ -476,7 +1156,16 @@ static int pkvinValue(KVINParser* prs)
         prs->value.end          = prs->lexer.lend;
         break;
     case KVIN_LEX_NUMBERLIKE    :
-        prs->value.type         = pkvinAnalyzeNumberLike(prs->lexer.lbeg, prs->lexer.lend, &prs->value.integer, &prs->value.real);
+        if (prs->validateOnly)
+        {
+            prs->value.real     = 0;
+            prs->value.integer  = 0;
+            prs->value.type     = pkvinScanNumberLike(prs->lexer.lbeg, prs->lexer.lend);
+        }
+        else
+        {
+            prs->value.type     = pkvinAnalyzeNumberLike(prs->lexer.lbeg, prs->lexer.lend, &prs->value.integer, &prs->value.real);
+        }
         if (prs->value.type == KVIN_VAL_NONE)
         {
             prs->state          = KVIN_PAR_ERROR;
@@ -500,7 +1189,13 @@ static int pkvinReset(KVINParser* prs)
     return 1;
 }
 
-static KVINParse kvinParseTable[KVIN_LEX_MAX][KVIN_PAR_MAX] =
+// constexpr in C++, so that rekvin_constexpr.cpp can check kvinLiteralTable
+// against it at compile time.
+#ifdef  __cplusplus
+static constexpr KVINParse kvinParseTable[KVIN_LEX_MAX][KVIN_PAR_MAX] =
+#else// __cplusplus
+static const KVINParse kvinParseTable[KVIN_LEX_MAX][KVIN_PAR_MAX] =
+#endif//__cplusplus
 {
                         /*  ERROR           INITIAL         ABSPATH         RELPATH         DOT             PATH            ASSIGN          EOL             DONE            */
     /* UNKNOWN    */    {   pkvinError,     pkvinError,     pkvinError,     pkvinError,     pkvinError,     pkvinError,     pkvinError,     pkvinError,     pkvinDone       },
@@ -575,6 +1270,1486 @@ int kvinParse(KVINActor* act)
     return (act->parser.state == KVIN_PAR_DONE);
 }
 
+int kvinLocate(const char* fst, const char* at, int* lineNo, int* column)
+{
+    kvin_assert(fst);
+    kvin_assert(fst <= at);
+
+    const char* lineBeg     = fst;
+    *lineNo                 = 1;
+    for (const char* cur = fst; cur < at; ++cur)
+    {
+        if (*cur == '\n')
+        {
+            ++*lineNo;
+            lineBeg         = cur + 1;
+        }
+    }
+    *column                 = (int)(at - lineBeg) + 1;
+    return 1;
+}
+
+// The byte at *cur in a BSTRING's text (value.begin to value.end), which it
+// steps past. An escape is one byte: \n, \t, \r and \0 are control bytes,
+// \xH or \xHH is that byte, and \ before anything else (even nothing) is
+// what follows it. Every front-end decodes byte-strings with this.
+int kvinUnescape(const char** cur, const char* end)
+{
+    kvin_assert(cur);
+    kvin_assert(*cur < end);
+
+    const char* at          = *cur;
+    if ((*at != '\\') || ((at + 1) >= end))
+    {
+        *cur                = at + 1;
+        return (unsigned char)*at;
+    }
+    int         c           = (unsigned char)*++at;
+    switch (c)
+    {
+    case 'n'    : c = '\n'; break;
+    case 't'    : c = '\t'; break;
+    case 'r'    : c = '\r'; break;
+    case '0'    : c = '\0'; break;
+    case 'x'    :
+        c                   = 0;
+        for (int HH = 0; (HH < 2) && ((at + 1) < end) && kvin_isxdigit(at[1]); ++HH)
+        {
+            c               = (c << 4) | kvin_digitval(*++at);
+        }
+        break;
+    default     : break;
+    }
+    *cur                    = at + 1;
+    return c;
+}
+
+int kvinInitPath(KVINPath* path, KVINValue* axes, int capacity)
+{
+    kvin_assert(path);
+    kvin_assert(axes || !capacity);
+
+    path->axes              = axes;
+    path->depth             = 0;
+    path->capacity          = capacity;
+    path->popped.type       = KVIN_VAL_NONE;
+    return 1;
+}
+
+// Returns 0 only if the path is deeper than its storage. UNCONVERTED axes, from
+// a validateOnly parser, are converted to INTEGER here.
+int kvinPathApply(KVINPath* path, const KVINParser* prs)
+{
+    kvin_assert(path);
+    kvin_assert(prs);
+
+    switch (prs->action)
+    {
+    case KVIN_ACT_SETATROOT     :
+        path->depth         = 0;
+        break;
+    case KVIN_ACT_SETNEXTAXIS   :
+        break;
+    case KVIN_ACT_RELPATH       :
+        if (path->depth > 0)
+        {
+            path->popped    = path->axes[--path->depth];
+        }
+        return 1;
+    case KVIN_ACT_AUTONUMBER    :
+        if (path->depth == path->capacity)
+        {
+            return 0;
+        }
+        path->axes[path->depth].type    = KVIN_VAL_INTEGER;
+        path->axes[path->depth].integer = (path->popped.type == KVIN_VAL_INTEGER) ? path->popped.integer + 1 : 0;
+        ++path->depth;
+        return 1;
+    default                     :
+        return 1;
+    }
+
+    if (path->depth == path->capacity)
+    {
+        return 0;
+    }
+    path->axes[path->depth]     = prs->value;
+    if (prs->value.type == KVIN_VAL_UNCONVERTED)
+    {
+        const char* last        = 0;
+        path->axes[path->depth].type    = KVIN_VAL_INTEGER;
+        path->axes[path->depth].integer = kvin_strtoull(prs->value.begin, prs->value.end, &last);
+    }
+    ++path->depth;
+    return 1;
+}
+
+// Orders integer axes numerically, before identifiers, which are bytewise.
+int kvinCompareAxis(const KVINValue* lhs, const KVINValue* rhs)
+{
+    if (lhs->type != rhs->type)
+    {
+        return (lhs->type == KVIN_VAL_INTEGER) ? -1 : 1;
+    }
+    if (lhs->type == KVIN_VAL_INTEGER)
+    {
+        return (lhs->integer < rhs->integer) ? -1 : (lhs->integer > rhs->integer);
+    }
+    const char* lcur        = lhs->begin;
+    const char* rcur        = rhs->begin;
+    for (; (lcur < lhs->end) && (rcur < rhs->end); ++lcur, ++rcur)
+    {
+        if (*lcur != *rcur)
+        {
+            return ((unsigned char)*lcur < (unsigned char)*rcur) ? -1 : 1;
+        }
+    }
+    return (lcur < lhs->end) - (rcur < rhs->end);
+}
+
+int kvinValidate(const char* fst, const char* lst, KVINError* errs, int maxErrs)
+{
+    kvin_assert(fst);
+    kvin_assert(lst);
+
+    int         numErrs     = 0;
+    int         lineNo      = 1;
+    const char* lineAt      = fst;
+    const char* lineBeg     = fst;
+    KVINParser  prs;
+
+    if (!kvinInitParser(&prs, fst, lst))
+    {
+        return 0;
+    }
+    prs.validateOnly        = 1;
+
+    for (;;)
+    {
+        KVIN_PARSES state   = prs.state;
+        if (kvinParseNext(&prs))
+        {
+            continue;
+        }
+        if (prs.state != KVIN_PAR_ERROR)
+        {
+            break;
+        }
+
+        const char* at      = (prs.lexer.lbeg < lst) ? prs.lexer.lbeg : lst;
+        if (numErrs < maxErrs)
+        {
+            while (lineAt < at)
+            {
+                if (*lineAt++ == '\n')
+                {
+                    ++lineNo;
+                    lineBeg = lineAt;
+                }
+            }
+            errs[numErrs].lineNo    = lineNo;
+            errs[numErrs].column    = (int)(at - lineBeg) + 1;
+            errs[numErrs].state     = state;
+            errs[numErrs].lex       = prs.lexer.lex;
+            errs[numErrs].at        = at;
+        }
+        ++numErrs;
+
+        // Recover at the start of the next line.
+        const char* cur     = prs.lexer.lend;
+        if (prs.lexer.lex != KVIN_LEX_EOL)
+        {
+            while ((cur < lst) && (*cur != '\n'))
+            {
+                ++cur;
+            }
+            prs.lexer.lineNo   += (cur < lst);
+            cur                += (cur < lst);
+        }
+        if (cur >= lst)
+        {
+            break;
+        }
+        prs.state           = KVIN_PAR_INITIAL;
+        prs.lexer.lex       = KVIN_LEX_UNKNOWN;
+        prs.lexer.lbeg      = cur;
+        prs.lexer.lend      = cur;
+    }
+
+    return numErrs;
+}
+
+#ifndef REKVIN_NO_STDLIB
+void* kvinStdRealloc(void* handle, void* ptr, size_t size)
+{
+    (void)handle;
+    if (size == 0)
+    {
+        free(ptr);
+        return 0;
+    }
+    return realloc(ptr, size);
+}
+#endif//REKVIN_NO_STDLIB
+
+static int pkvinGrow(kvinReallocFptr Realloc, void* handle, void** ptr, int* cap, int need, size_t elemSize)
+{
+    if (need <= *cap)
+    {
+        return 1;
+    }
+    int     grown           = *cap ? *cap : 64;
+    while (grown < need)
+    {
+        grown              *= 2;
+    }
+    void   *mem             = Realloc(handle, *ptr, grown * elemSize);
+    if (!mem)
+    {
+        return 0;
+    }
+    *ptr                    = mem;
+    *cap                    = grown;
+    return 1;
+}
+
+static int pkvinDocGrow(KVINDoc* doc, void** ptr, int* cap, int need, size_t elemSize)
+{
+    return pkvinGrow(doc->Realloc, doc->handle, ptr, cap, need, elemSize);
+}
+
+// FNV-1a over an axis, shared by the document's and the schema's tables.
+static unsigned long long pkvinHashAxis(unsigned long long hash, const KVINValue* axis)
+{
+    if (axis->type == KVIN_VAL_INTEGER)
+    {
+        return (hash ^ axis->integer) * 1099511628211ull;
+    }
+    for (const char* cur = axis->begin; cur < axis->end; ++cur)
+    {
+        hash                = (hash ^ (unsigned char)*cur) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static size_t pkvinHashFold(unsigned long long hash)
+{
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+typedef size_t (*pkvinHashFptr)(const void* ctx, int idx);
+
+static void pkvinTableInsert(int* table, size_t mask, size_t hash, int idx)
+{
+    size_t  slot            = hash & mask;
+    while (table[slot] >= 0)
+    {
+        slot                = (slot + 1) & mask;
+    }
+    table[slot]             = idx;
+}
+
+// Doubles an open-addressed table of indices (or makes one), rehashing it.
+static int pkvinGrowTable(kvinReallocFptr Realloc, void* handle, int** table, size_t* mask, pkvinHashFptr Hash, const void* ctx)
+{
+    size_t  oldSize         = *table ? *mask + 1 : 0;
+    size_t  size            = oldSize ? 2 * oldSize : 64;
+    int    *grown           = (int*)Realloc(handle, 0, size * sizeof(int));
+    if (!grown)
+    {
+        return 0;
+    }
+    for (size_t II = 0; II < size; ++II)
+    {
+        grown[II]           = -1;
+    }
+    for (size_t II = 0; II < oldSize; ++II)
+    {
+        if ((*table)[II] >= 0)
+        {
+            pkvinTableInsert(grown, size - 1, Hash(ctx, (*table)[II]), (*table)[II]);
+        }
+    }
+    if (*table)
+    {
+        Realloc(handle, *table, 0);
+    }
+    *table                  = grown;
+    *mask                   = size - 1;
+    return 1;
+}
+
+static size_t pkvinDocHash(int parentUid, const KVINValue* key)
+{
+    return pkvinHashFold(pkvinHashAxis(14695981039346656037ull ^ (unsigned)parentUid, key));
+}
+
+static size_t pkvinDocNodeHash(const void* ctx, int idx)
+{
+    const KVINDocNode*  node    = &((const KVINDoc*)ctx)->nodes[idx];
+    return pkvinDocHash(node->parentUid, &node->key);
+}
+
+static void pkvinDocFreeColumn(KVINDoc* doc, int node)
+{
+    int column              = doc->nodes[node].column;
+    if (column >= 0)
+    {
+        if (doc->columns[column].data)
+        {
+            doc->Realloc(doc->handle, doc->columns[column].data, 0);
+        }
+        doc->columns[column].data       = 0;
+        doc->columns[column].length     = 0;
+        doc->columns[column].capacity   = 0;
+        doc->nodes[node].column         = -1;
+    }
+}
+
+static void pkvinDocReset(KVINDoc* doc, int idx)
+{
+    KVINDocNode* node       = &doc->nodes[idx];
+    node->uid               = ++doc->nextUid;
+    node->value.type        = KVIN_VAL_NONE;
+    node->first             = -1;
+    node->last              = -1;
+    node->numChildren       = 0;
+    node->numInts           = 0;
+    node->maxIndex          = 0;
+    node->column            = -1;
+}
+
+static int pkvinDocInsert(KVINDoc* doc, int parent, const KVINValue* key)
+{
+    if (((doc->numNodes + 1) * 2 > (int)(doc->mask + 1))
+     && !pkvinGrowTable(doc->Realloc, doc->handle, &doc->table, &doc->mask, pkvinDocNodeHash, doc))
+    {
+        return -1;
+    }
+    if (!pkvinDocGrow(doc, (void**)&doc->nodes, &doc->capNodes, doc->numNodes + 1, sizeof(KVINDocNode)))
+    {
+        return -1;
+    }
+
+    int             idx     = doc->numNodes++;
+    KVINDocNode    *node    = &doc->nodes[idx];
+    KVINDocNode    *up      = &doc->nodes[parent];
+    pkvinDocReset(doc, idx);
+    node->key               = *key;
+    node->parent            = parent;
+    node->parentUid         = up->uid;
+    node->next              = -1;
+    if (up->last >= 0)
+    {
+        doc->nodes[up->last].next   = idx;
+    }
+    else
+    {
+        up->first           = idx;
+    }
+    up->last                = idx;
+    ++up->numChildren;
+    if (key->type == KVIN_VAL_INTEGER)
+    {
+        ++up->numInts;
+        up->maxIndex        = (key->integer > up->maxIndex) ? key->integer : up->maxIndex;
+    }
+
+    pkvinTableInsert(doc->table, doc->mask, pkvinDocHash(node->parentUid, key), idx);
+    return idx;
+}
+
+static int pkvinDocAppend(KVINDoc* doc, KVINColumn* column, const KVINValue* value)
+{
+    if (column->length == column->capacity)
+    {
+        size_t  capacity    = column->capacity ? 2 * column->capacity : 16;
+        size_t  elemSize    = (column->type == KVIN_VAL_INTEGER) ? sizeof(unsigned long long) : sizeof(double);
+        void   *data        = doc->Realloc(doc->handle, column->data, capacity * elemSize);
+        if (!data)
+        {
+            return 0;
+        }
+        column->data        = data;
+        column->capacity    = capacity;
+    }
+    if (column->type == KVIN_VAL_INTEGER)
+    {
+        column->integers[column->length++]  = value->integer;
+    }
+    else
+    {
+        column->reals[column->length++]     = (double)value->real;
+    }
+    return 1;
+}
+
+static int pkvinDocStartColumn(KVINDoc* doc, int node, const KVINValue* key, const KVINValue* value)
+{
+    if (!pkvinDocGrow(doc, (void**)&doc->columns, &doc->capColumns, doc->numColumns + 1, sizeof(KVINColumn)))
+    {
+        return 0;
+    }
+    KVINColumn* column      = &doc->columns[doc->numColumns];
+    column->type            = value->type;
+    column->base            = key->integer;
+    column->length          = 0;
+    column->capacity        = 0;
+    column->data            = 0;
+    doc->nodes[node].column = doc->numColumns++;
+    return pkvinDocAppend(doc, column, value);
+}
+
+// Turns a node's column back into one node per element.
+static int pkvinDocSpill(KVINDoc* doc, int node)
+{
+    KVINColumn  column      = doc->columns[doc->nodes[node].column];
+    KVINValue   key;
+    key.type                = KVIN_VAL_INTEGER;
+    for (size_t II = 0; II < column.length; ++II)
+    {
+        key.integer         = column.base + II;
+        int child           = pkvinDocInsert(doc, node, &key);
+        if (child < 0)
+        {
+            return 0;
+        }
+        doc->nodes[child].value.type    = column.type;
+        if (column.type == KVIN_VAL_INTEGER)
+        {
+            doc->nodes[child].value.integer = column.integers[II];
+        }
+        else
+        {
+            doc->nodes[child].value.real    = column.reals[II];
+        }
+    }
+    pkvinDocFreeColumn(doc, node);
+    return 1;
+}
+
+int kvinInitDoc(KVINDoc* doc, kvinReallocFptr Realloc, void* handle)
+{
+    kvin_assert(doc);
+    kvin_assert(Realloc);
+
+    KVINDoc empty           = { 0 };
+    *doc                    = empty;
+    doc->Realloc            = Realloc;
+    doc->handle             = handle;
+    if (!pkvinGrowTable(Realloc, handle, &doc->table, &doc->mask, pkvinDocNodeHash, doc)
+     || !pkvinDocGrow(doc, (void**)&doc->nodes, &doc->capNodes, 1, sizeof(KVINDocNode)))
+    {
+        kvinFreeDoc(doc);
+        return 0;
+    }
+    // The root is node 0, and is its own (never matching) parent.
+    doc->numNodes           = 1;
+    pkvinDocReset(doc, 0);
+    doc->nodes[0].key.type  = KVIN_VAL_NONE;
+    doc->nodes[0].parent    = 0;
+    doc->nodes[0].parentUid = -1;
+    doc->nodes[0].next      = -1;
+    return 1;
+}
+
+void kvinFreeDoc(KVINDoc* doc)
+{
+    if (!doc || !doc->Realloc)
+    {
+        return;
+    }
+    for (int II = 0; II < doc->numColumns; ++II)
+    {
+        if (doc->columns[II].data)
+        {
+            doc->Realloc(doc->handle, doc->columns[II].data, 0);
+        }
+    }
+    void* blocks[]          = { doc->nodes, doc->columns, doc->table, doc->nodeAt };
+    for (int II = 0; II < (int)(sizeof(blocks) / sizeof(blocks[0])); ++II)
+    {
+        if (blocks[II])
+        {
+            doc->Realloc(doc->handle, blocks[II], 0);
+        }
+    }
+    doc->nodes              = 0;
+    doc->columns            = 0;
+    doc->table              = 0;
+    doc->nodeAt             = 0;
+    doc->numNodes           = 0;
+    doc->numColumns         = 0;
+}
+
+int kvinDocFind(const KVINDoc* doc, int node, const KVINValue* key)
+{
+    kvin_assert(doc);
+
+    int uid                 = doc->nodes[node].uid;
+    for (size_t slot = pkvinDocHash(uid, key) & doc->mask; ; slot = (slot + 1) & doc->mask)
+    {
+        int idx             = doc->table[slot];
+        if (idx < 0)
+        {
+            return -1;
+        }
+        const KVINDocNode* child    = &doc->nodes[idx];
+        if ((child->parent == node) && (child->parentUid == uid) && (kvinCompareAxis(&child->key, key) == 0))
+        {
+            return idx;
+        }
+    }
+}
+
+const KVINColumn* kvinDocColumn(const KVINDoc* doc, int node)
+{
+    kvin_assert(doc);
+    return (doc->nodes[node].column >= 0) ? &doc->columns[doc->nodes[node].column] : 0;
+}
+
+// Stores one value at path; nodeAt[0..resolved] are already known.
+static int pkvinDocSet(KVINDoc* doc, const KVINPath* path, const KVINValue* value, int resolved)
+{
+    int*    nodeAt          = doc->nodeAt;
+    for (int DD = resolved; DD < path->depth; ++DD)
+    {
+        const KVINValue*    key     = &path->axes[DD];
+        int                 parent  = nodeAt[DD];
+        int                 leaf    = (DD + 1 == path->depth);
+        int                 dense   = leaf && (key->type == KVIN_VAL_INTEGER)
+                                    && ((value->type == KVIN_VAL_INTEGER) || (value->type == KVIN_VAL_REAL));
+        if (doc->nodes[parent].column >= 0)
+        {
+            KVINColumn* column      = &doc->columns[doc->nodes[parent].column];
+            if (dense && (value->type == column->type) && (key->integer == column->base + column->length))
+            {
+                return pkvinDocAppend(doc, column, value);
+            }
+            if (!pkvinDocSpill(doc, parent))
+            {
+                return 0;
+            }
+        }
+        else
+        if (dense && (doc->nodes[parent].numChildren == 0))
+        {
+            return pkvinDocStartColumn(doc, parent, key, value);
+        }
+
+        int child           = kvinDocFind(doc, parent, key);
+        if (child < 0)
+        {
+            child           = pkvinDocInsert(doc, parent, key);
+            if (child < 0)
+            {
+                return 0;
+            }
+        }
+        if (!leaf)
+        {
+            doc->nodes[child].value.type    = KVIN_VAL_NONE;
+            nodeAt[DD + 1]  = child;
+            continue;
+        }
+        if ((doc->nodes[child].value.type == KVIN_VAL_NONE) && ((doc->nodes[child].numChildren > 0) || (doc->nodes[child].column >= 0)))
+        {
+            pkvinDocFreeColumn(doc, child);
+            pkvinDocReset(doc, child);
+        }
+        doc->nodes[child].value = *value;
+    }
+    return 1;
+}
+
+// Parses everything prs has left into doc. On failure, prs->state is
+// KVIN_PAR_ERROR for a syntax error; otherwise memory or path storage ran out.
+int kvinDocLoad(KVINDoc* doc, KVINParser* prs, KVINPath* path)
+{
+    kvin_assert(doc);
+    kvin_assert(prs);
+    kvin_assert(path);
+    if (!pkvinDocGrow(doc, (void**)&doc->nodeAt, &doc->capNodeAt, path->capacity + 1, sizeof(int)))
+    {
+        return 0;
+    }
+
+    int resolved            = 0;
+    int more                = 0;
+    doc->nodeAt[0]          = 0;
+    do
+    {
+        more                = kvinParseNext(prs);
+        if (!kvinPathApply(path, prs))
+        {
+            return 0;
+        }
+        switch (prs->action)
+        {
+        case KVIN_ACT_SETATROOT     : resolved = 0; break;
+        case KVIN_ACT_RELPATH       : resolved = (resolved < path->depth) ? resolved : path->depth; break;
+        case KVIN_ACT_SETVALUE      :
+            if (path->depth > 0)
+            {
+                if (!pkvinDocSet(doc, path, &prs->value, resolved))
+                {
+                    return 0;
+                }
+                resolved    = path->depth - 1;
+            }
+            break;
+        default                     : break;
+        }
+    }
+    while (more);
+
+    return (prs->state == KVIN_PAR_DONE);
+}
+
+#define KVIN_SCHEMA_DEPTH       256     // Path storage for kvinSchemaValidate.
+#define KVIN_SCHEMA_ANY         ((1 << KVIN_VAL_IDENTIFIER) | (1 << KVIN_VAL_INTEGER) | (1 << KVIN_VAL_REAL) | (1 << KVIN_VAL_BSTRING))
+
+static size_t pkvinSchemaNameHash(const void* ctx, int idx)
+{
+    return pkvinHashFold(pkvinHashAxis(14695981039346656037ull, &((const KVINSchema*)ctx)->names[idx]));
+}
+
+// Identifier edges are keyed by interned name, integer ones by the integer.
+static size_t pkvinSchemaEdge(int parent, int name, unsigned long long integer)
+{
+    unsigned long long hash = (14695981039346656037ull ^ (unsigned)parent) * 1099511628211ull;
+    hash                    = (hash ^ (unsigned)(name + 1)) * 1099511628211ull;
+    hash                    = (hash ^ integer) * 1099511628211ull;
+    return pkvinHashFold(hash);
+}
+
+static size_t pkvinSchemaEdgeHash(const void* ctx, int idx)
+{
+    const KVINSchemaNode*   node    = &((const KVINSchema*)ctx)->nodes[idx];
+    return pkvinSchemaEdge(node->parent, node->name, (node->name < 0) ? node->key.integer : 0);
+}
+
+static size_t pkvinSchemaKeysHash(int node, const KVINValue* keys, int numKeys)
+{
+    unsigned long long hash = 14695981039346656037ull ^ (unsigned)node;
+    for (int II = 0; II < numKeys; ++II)
+    {
+        hash                = pkvinHashAxis(hash, &keys[II]);
+    }
+    return pkvinHashFold(hash);
+}
+
+static size_t pkvinSchemaSeenHash(const void* ctx, int idx)
+{
+    return ((const KVINSchemaCheck*)ctx)->seen[idx].hash;
+}
+
+static int pkvinSchemaFindName(const KVINSchema* schema, const KVINValue* axis)
+{
+    size_t  hash            = pkvinHashFold(pkvinHashAxis(14695981039346656037ull, axis));
+    for (size_t slot = hash & schema->nameMask; ; slot = (slot + 1) & schema->nameMask)
+    {
+        int idx             = schema->nameTable[slot];
+        if ((idx < 0) || (kvinCompareAxis(&schema->names[idx], axis) == 0))
+        {
+            return idx;
+        }
+    }
+}
+
+static int pkvinSchemaFindEdge(const KVINSchema* schema, int parent, int name, unsigned long long integer)
+{
+    for (size_t slot = pkvinSchemaEdge(parent, name, integer) & schema->edgeMask; ; slot = (slot + 1) & schema->edgeMask)
+    {
+        int idx             = schema->edgeTable[slot];
+        if (idx < 0)
+        {
+            return -1;
+        }
+        const KVINSchemaNode* node  = &schema->nodes[idx];
+        if ((node->parent == parent) && (node->name == name) && ((name >= 0) || (node->key.integer == integer)))
+        {
+            return idx;
+        }
+    }
+}
+
+// The node an axis leads to from parent: an exact match, else `[*]` (for an
+// integer), else `*`, else -1.
+static int pkvinSchemaChild(const KVINSchema* schema, int parent, const KVINValue* axis)
+{
+    const KVINSchemaNode*   node    = &schema->nodes[parent];
+    int                     child   = -1;
+    if (axis->type == KVIN_VAL_INTEGER)
+    {
+        child               = pkvinSchemaFindEdge(schema, parent, -1, axis->integer);
+        child               = (child >= 0) ? child : node->anyIndex;
+    }
+    else
+    {
+        int name            = pkvinSchemaFindName(schema, axis);
+        child               = (name >= 0) ? pkvinSchemaFindEdge(schema, parent, name, 0) : -1;
+    }
+    return (child >= 0) ? child : node->anyAxis;
+}
+
+static int pkvinSchemaIntern(KVINSchema* schema, const KVINValue* axis)
+{
+    int name                = pkvinSchemaFindName(schema, axis);
+    if (name >= 0)
+    {
+        return name;
+    }
+    if (((schema->numNames + 1) * 2 > (int)(schema->nameMask + 1))
+     && !pkvinGrowTable(schema->Realloc, schema->handle, &schema->nameTable, &schema->nameMask, pkvinSchemaNameHash, schema))
+    {
+        return -1;
+    }
+    if (!pkvinGrow(schema->Realloc, schema->handle, (void**)&schema->names, &schema->capNames, schema->numNames + 1, sizeof(KVINValue)))
+    {
+        return -1;
+    }
+    name                    = schema->numNames++;
+    schema->names[name]     = *axis;
+    pkvinTableInsert(schema->nameTable, schema->nameMask, pkvinSchemaNameHash(schema, name), name);
+    return name;
+}
+
+// The child of parent for one axis of a rule's path, made if need be. A NONE
+// axis is `[*]` if anyIndex, otherwise `*`.
+static int pkvinSchemaAdd(KVINSchema* schema, int parent, const KVINValue* axis, int anyIndex)
+{
+    int name                = -1;
+    int child               = anyIndex ? schema->nodes[parent].anyIndex : schema->nodes[parent].anyAxis;
+    if (axis->type != KVIN_VAL_NONE)
+    {
+        if ((axis->type == KVIN_VAL_IDENTIFIER) && ((name = pkvinSchemaIntern(schema, axis)) < 0))
+        {
+            return -1;
+        }
+        child               = pkvinSchemaFindEdge(schema, parent, name, (name < 0) ? axis->integer : 0);
+    }
+    if (child >= 0)
+    {
+        return child;
+    }
+    if (((schema->numNodes + 1) * 2 > (int)(schema->edgeMask + 1))
+     && !pkvinGrowTable(schema->Realloc, schema->handle, &schema->edgeTable, &schema->edgeMask, pkvinSchemaEdgeHash, schema))
+    {
+        return -1;
+    }
+    if (!pkvinGrow(schema->Realloc, schema->handle, (void**)&schema->nodes, &schema->capNodes, schema->numNodes + 1, sizeof(KVINSchemaNode)))
+    {
+        return -1;
+    }
+
+    child                   = schema->numNodes++;
+    KVINSchemaNode* node    = &schema->nodes[child];
+    node->key               = *axis;
+    node->name              = name;
+    node->parent            = parent;
+    node->types             = 0;
+    node->required          = 0;
+    node->open              = 0;
+    node->min.type          = KVIN_VAL_NONE;
+    node->max.type          = KVIN_VAL_NONE;
+    node->anyIndex          = -1;
+    node->anyAxis           = -1;
+    node->bit               = -1;
+    node->requiredMask      = 0;
+    node->requiredAt        = -1;
+    if (axis->type != KVIN_VAL_NONE)
+    {
+        pkvinTableInsert(schema->edgeTable, schema->edgeMask, pkvinSchemaEdgeHash(schema, child), child);
+    }
+    else
+    if (anyIndex)
+    {
+        schema->nodes[parent].anyIndex  = child;
+    }
+    else
+    {
+        schema->nodes[parent].anyAxis   = child;
+    }
+    return child;
+}
+
+// Compiles a rule's path, as "a.b[*].*" or "[0].c", to its node; -1 if it is
+// not one.
+static int pkvinSchemaPath(KVINSchema* schema, const KVINValue* path)
+{
+    const char* cur         = path->begin;
+    const char* end         = path->end;
+    const char* last        = 0;
+    int         node        = 0;
+    if (cur == end)
+    {
+        return -1;
+    }
+    while ((node >= 0) && (cur < end))
+    {
+        KVINValue   axis;
+        int         anyIndex    = 0;
+        axis.type               = KVIN_VAL_NONE;
+        if (*cur == '[')
+        {
+            const char* close   = cur + 1;
+            while ((close < end) && (*close != ']'))
+            {
+                ++close;
+            }
+            if (close == end)
+            {
+                return -1;
+            }
+            if ((close == cur + 2) && (cur[1] == '*'))
+            {
+                anyIndex        = 1;
+            }
+            else
+            {
+                axis.type       = KVIN_VAL_INTEGER;
+                axis.integer    = kvin_strtoull(cur + 1, close, &last);
+                if (last != close)
+                {
+                    return -1;
+                }
+            }
+            cur                 = close + 1;
+        }
+        else
+        {
+            if ((node != 0) && ((*cur != '.') || (++cur == end)))
+            {
+                return -1;
+            }
+            if (*cur == '*')
+            {
+                ++cur;
+            }
+            else
+            if (kvin_iscid(*cur))
+            {
+                axis.type       = KVIN_VAL_IDENTIFIER;
+                axis.begin      = cur;
+                while ((cur < end) && kvin_iscidn(*cur))
+                {
+                    ++cur;
+                }
+                axis.end        = cur;
+            }
+            else
+            {
+                axis.type       = KVIN_VAL_INTEGER;
+                axis.integer    = kvin_strtoull(cur, end, &last);
+                if (last == cur)
+                {
+                    return -1;
+                }
+                cur             = last;
+            }
+        }
+        node                    = pkvinSchemaAdd(schema, node, &axis, anyIndex);
+    }
+    return node;
+}
+
+static int pkvinSchemaIs(const KVINValue* value, const char* word)
+{
+    if (value->type != KVIN_VAL_IDENTIFIER)
+    {
+        return 0;
+    }
+    const char* cur         = value->begin;
+    for (; (cur < value->end) && *word; ++cur, ++word)
+    {
+        if (*cur != *word)
+        {
+            return 0;
+        }
+    }
+    return (cur == value->end) && !*word;
+}
+
+static int pkvinSchemaFail(KVINSchemaError* err, const KVINValue* key)
+{
+    err->kind               = KVIN_SCH_RULE;
+    err->at                 = (key->type == KVIN_VAL_IDENTIFIER) ? key->begin : 0;
+    return 0;
+}
+
+static int pkvinSchemaRule(KVINSchema* schema, const KVINDoc* doc, int rule, KVINSchemaError* err)
+{
+    static const char* const    typeNames[] = { "integer", "real", "number", "identifier", "bstring", "any" };
+    static const int            typeBits[]  =
+    {
+        1 << KVIN_VAL_INTEGER,
+        1 << KVIN_VAL_REAL,
+        (1 << KVIN_VAL_INTEGER) | (1 << KVIN_VAL_REAL),
+        1 << KVIN_VAL_IDENTIFIER,
+        1 << KVIN_VAL_BSTRING,
+        KVIN_SCHEMA_ANY,
+    };
+
+    int first               = doc->nodes[rule].first;
+    int node                = -1;
+    if ((doc->nodes[rule].value.type != KVIN_VAL_NONE) || (first < 0))
+    {
+        return pkvinSchemaFail(err, &doc->nodes[rule].key);
+    }
+    for (int field = first; field >= 0; field = doc->nodes[field].next)
+    {
+        if (pkvinSchemaIs(&doc->nodes[field].key, "path"))
+        {
+            node            = (doc->nodes[field].value.type == KVIN_VAL_BSTRING) ? pkvinSchemaPath(schema, &doc->nodes[field].value) : -1;
+            if (node < 0)
+            {
+                return pkvinSchemaFail(err, &doc->nodes[field].key);
+            }
+        }
+    }
+    if (node < 0)
+    {
+        return pkvinSchemaFail(err, &doc->nodes[first].key);
+    }
+
+    KVINSchemaNode* target  = &schema->nodes[node];
+    target->types           = KVIN_SCHEMA_ANY;
+    for (int field = first; field >= 0; field = doc->nodes[field].next)
+    {
+        const KVINValue*    key     = &doc->nodes[field].key;
+        const KVINValue*    value   = &doc->nodes[field].value;
+        int                 flag    = (value->type == KVIN_VAL_INTEGER) && (value->integer <= 1);
+        int                 bound   = (value->type == KVIN_VAL_INTEGER) || (value->type == KVIN_VAL_REAL);
+        int                 known   = pkvinSchemaIs(key, "path");
+        for (int TT = 0; pkvinSchemaIs(key, "type") && (TT < (int)(sizeof(typeBits) / sizeof(typeBits[0]))); ++TT)
+        {
+            if (pkvinSchemaIs(value, typeNames[TT]))
+            {
+                target->types   = typeBits[TT];
+                known           = 1;
+            }
+        }
+        if (pkvinSchemaIs(key, "min") && bound)
+        {
+            target->min     = *value;
+            known           = 1;
+        }
+        if (pkvinSchemaIs(key, "max") && bound)
+        {
+            target->max     = *value;
+            known           = 1;
+        }
+        if (pkvinSchemaIs(key, "open") && flag)
+        {
+            target->open    = (int)value->integer;
+            known           = 1;
+        }
+        if (pkvinSchemaIs(key, "required") && flag)
+        {
+            target->required    = (int)value->integer;
+            known               = 1;
+        }
+        if (!known)
+        {
+            return pkvinSchemaFail(err, key);
+        }
+    }
+
+    // Each required child has a bit in its parent's mask, of which there are
+    // 64, and is listed by it in the parent's block of requiredChild.
+    KVINSchemaNode* parent  = &schema->nodes[target->parent];
+    if (target->required && (target->bit < 0))
+    {
+        unsigned long long  mask    = parent->requiredMask;
+        int                 bit     = 0;
+        for (; mask; mask &= mask - 1)
+        {
+            ++bit;
+        }
+        if (bit == 64)
+        {
+            return pkvinSchemaFail(err, &doc->nodes[first].key);
+        }
+        if (parent->requiredAt < 0)
+        {
+            if (!pkvinGrow(schema->Realloc, schema->handle, (void**)&schema->requiredChild, &schema->capRequired, schema->numRequired + 64, sizeof(int)))
+            {
+                return 0;
+            }
+            parent->requiredAt      = schema->numRequired;
+            schema->numRequired    += 64;
+        }
+        target->bit             = bit;
+        parent->requiredMask   |= 1ull << bit;
+        schema->requiredChild[parent->requiredAt + bit] = node;
+    }
+    return 1;
+}
+
+int kvinInitSchema(KVINSchema* schema, kvinReallocFptr Realloc, void* handle)
+{
+    kvin_assert(schema);
+    kvin_assert(Realloc);
+
+    KVINSchema  empty       = { 0 };
+    *schema                 = empty;
+    schema->Realloc         = Realloc;
+    schema->handle          = handle;
+    if (!pkvinGrowTable(Realloc, handle, &schema->nameTable, &schema->nameMask, pkvinSchemaNameHash, schema)
+     || !pkvinGrowTable(Realloc, handle, &schema->edgeTable, &schema->edgeMask, pkvinSchemaEdgeHash, schema)
+     || !pkvinGrow(Realloc, handle, (void**)&schema->nodes, &schema->capNodes, 1, sizeof(KVINSchemaNode)))
+    {
+        kvinFreeSchema(schema);
+        return 0;
+    }
+    // The root matches no axis, and takes no value.
+    KVINSchemaNode* root    = &schema->nodes[0];
+    schema->numNodes        = 1;
+    root->key.type          = KVIN_VAL_NONE;
+    root->name              = -1;
+    root->parent            = -1;
+    root->types             = 0;
+    root->required          = 0;
+    root->open              = 0;
+    root->min.type          = KVIN_VAL_NONE;
+    root->max.type          = KVIN_VAL_NONE;
+    root->anyIndex          = -1;
+    root->anyAxis           = -1;
+    root->bit               = -1;
+    root->requiredMask      = 0;
+    root->requiredAt        = -1;
+    return 1;
+}
+
+// Compiles the rules in [fst, lst), which must outlive the schema. On failure
+// err says where: a syntax error, or a rule that is not one (an unknown
+// field, a bad path, type or bound); the rules before it are kept.
+int kvinSchemaLoad(KVINSchema* schema, const char* fst, const char* lst, KVINSchemaError* err)
+{
+    kvin_assert(schema);
+    kvin_assert(err);
+
+    KVINValue   axes[16];
+    KVINPath    path;
+    KVINParser  prs;
+    KVINDoc     doc;
+    err->kind               = KVIN_SCH_RULE;
+    err->lineNo             = 0;
+    err->column             = 0;
+    err->node               = -1;
+    err->value.type         = KVIN_VAL_NONE;
+    err->at                 = 0;
+    kvinInitPath(&path, axes, 16);
+    if (!kvinInitParser(&prs, fst, lst))
+    {
+        return 1;
+    }
+    if (!kvinInitDoc(&doc, schema->Realloc, schema->handle))
+    {
+        return 0;
+    }
+
+    int loaded              = kvinDocLoad(&doc, &prs, &path);
+    if (!loaded)
+    {
+        err->kind           = (prs.state == KVIN_PAR_ERROR) ? KVIN_SCH_SYNTAX : KVIN_SCH_DEPTH;
+        err->at             = (prs.lexer.lbeg < lst) ? prs.lexer.lbeg : lst;
+    }
+    for (int top = doc.nodes[0].first; loaded && (top >= 0); top = doc.nodes[top].next)
+    {
+        const KVINDocNode*  list    = &doc.nodes[top];
+        loaded              = pkvinSchemaIs(&list->key, "rule") && (list->value.type == KVIN_VAL_NONE) && (list->column < 0);
+        if (!loaded)
+        {
+            pkvinSchemaFail(err, &list->key);
+        }
+        for (int rule = list->first; loaded && (rule >= 0); rule = doc.nodes[rule].next)
+        {
+            loaded          = pkvinSchemaRule(schema, &doc, rule, err);
+        }
+    }
+    kvinFreeDoc(&doc);
+    if (!loaded && err->at)
+    {
+        kvinLocate(fst, err->at, &err->lineNo, &err->column);
+    }
+    return loaded;
+}
+
+void kvinFreeSchema(KVINSchema* schema)
+{
+    if (!schema || !schema->Realloc)
+    {
+        return;
+    }
+    void* blocks[]          = { schema->nodes, schema->names, schema->nameTable, schema->edgeTable, schema->requiredChild };
+    for (int II = 0; II < (int)(sizeof(blocks) / sizeof(blocks[0])); ++II)
+    {
+        if (blocks[II])
+        {
+            schema->Realloc(schema->handle, blocks[II], 0);
+        }
+    }
+    schema->nodes           = 0;
+    schema->names           = 0;
+    schema->nameTable       = 0;
+    schema->edgeTable       = 0;
+    schema->requiredChild   = 0;
+    schema->numNodes        = 0;
+    schema->numNames        = 0;
+    schema->numRequired     = 0;
+}
+
+// Errors are found in text order, so lines are counted as they go.
+static void pkvinSchemaReport(KVINSchemaCheck* chk, KVIN_SCHEMA_ERROR kind, int node, const KVINValue* value, const char* at)
+{
+    if (chk->numErrs < chk->maxErrs)
+    {
+        KVINSchemaError*    err = &chk->errs[chk->numErrs];
+        err->kind               = kind;
+        err->lineNo             = 0;
+        err->column             = 0;
+        err->node               = node;
+        err->value.type         = KVIN_VAL_NONE;
+        err->at                 = at;
+        if (value)
+        {
+            err->value          = *value;
+        }
+        if (at)
+        {
+            while (chk->lineAt < at)
+            {
+                if (*chk->lineAt++ == '\n')
+                {
+                    ++chk->lineNo;
+                    chk->lineBeg    = chk->lineAt;
+                }
+            }
+            err->lineNo         = chk->lineNo;
+            err->column         = (int)(at - chk->lineBeg) + 1;
+        }
+    }
+    ++chk->numErrs;
+}
+
+// The KVINSchemaSeen for the node at depth, found by the node and the axes its
+// path's `[*]` and `*` matched, or made; -1 if out of memory.
+static int pkvinSchemaSee(KVINSchemaCheck* chk, const KVINPath* path, int depth, const char* at)
+{
+    const KVINSchema*   schema  = chk->schema;
+    int                 node    = chk->nodeAt[depth];
+    int                 numKeys = 0;
+    if (!pkvinGrow(schema->Realloc, schema->handle, (void**)&chk->keys, &chk->capKeys, chk->numKeys + depth, sizeof(KVINValue)))
+    {
+        return -1;
+    }
+    KVINValue*          keys    = &chk->keys[chk->numKeys];
+    for (int DD = 1; DD <= depth; ++DD)
+    {
+        if (schema->nodes[chk->nodeAt[DD]].key.type == KVIN_VAL_NONE)
+        {
+            keys[numKeys++]     = path->axes[DD - 1];
+        }
+    }
+    size_t              hash    = pkvinSchemaKeysHash(node, keys, numKeys);
+    for (size_t slot = hash & chk->seenMask; chk->seenTable[slot] >= 0; slot = (slot + 1) & chk->seenMask)
+    {
+        const KVINSchemaSeen*   seen    = &chk->seen[chk->seenTable[slot]];
+        int                     same    = (seen->hash == hash) && (seen->node == node) && (seen->numKeys == numKeys);
+        for (int KK = 0; same && (KK < numKeys); ++KK)
+        {
+            same                = (kvinCompareAxis(&chk->keys[seen->keys + KK], &keys[KK]) == 0);
+        }
+        if (same)
+        {
+            return chk->seenTable[slot];
+        }
+    }
+    if (((chk->numSeen + 1) * 2 > (int)(chk->seenMask + 1))
+     && !pkvinGrowTable(schema->Realloc, schema->handle, &chk->seenTable, &chk->seenMask, pkvinSchemaSeenHash, chk))
+    {
+        return -1;
+    }
+    if (!pkvinGrow(schema->Realloc, schema->handle, (void**)&chk->seen, &chk->capSeen, chk->numSeen + 1, sizeof(KVINSchemaSeen)))
+    {
+        return -1;
+    }
+    int                 idx     = chk->numSeen++;
+    chk->seen[idx].node         = node;
+    chk->seen[idx].keys         = chk->numKeys;
+    chk->seen[idx].numKeys      = numKeys;
+    chk->seen[idx].found        = 0;
+    chk->seen[idx].hash         = hash;
+    chk->seen[idx].at           = at;
+    chk->numKeys               += numKeys;
+    pkvinTableInsert(chk->seenTable, chk->seenMask, hash, idx);
+    return idx;
+}
+
+// Follows the axis the parser just set from the node its parent matched.
+static int pkvinSchemaEnter(KVINSchemaCheck* chk, const KVINPath* path, const KVINParser* prs)
+{
+    const KVINSchema*   schema  = chk->schema;
+    int                 depth   = path->depth;
+    if ((depth == 0) || (depth > chk->capacity))
+    {
+        return 0;
+    }
+
+    const KVINValue*    axis    = &path->axes[depth - 1];
+    const char*         at      = (axis->type == KVIN_VAL_IDENTIFIER) ? axis->begin : prs->lexer.lbeg;
+    while ((axis->type == KVIN_VAL_INTEGER) && (prs->lexer.lex == KVIN_LEX_RBRACKET) && (*at != '['))
+    {
+        --at;
+    }
+    int                 parent  = chk->nodeAt[depth - 1];
+    int                 node    = parent;
+    chk->seenAt[depth]          = -1;
+    if (parent >= 0)
+    {
+        node                    = pkvinSchemaChild(schema, parent, axis);
+        if ((node < 0) && schema->nodes[parent].open)
+        {
+            node                = KVIN_SCHEMA_OPEN;
+        }
+        else
+        if (node < 0)
+        {
+            pkvinSchemaReport(chk, KVIN_SCH_UNKNOWN, parent, axis, at);
+        }
+    }
+    chk->nodeAt[depth]          = node;
+    if (node < 0)
+    {
+        return 1;
+    }
+
+    const KVINSchemaNode*   entered = &schema->nodes[node];
+    if ((entered->bit >= 0) && (chk->seenAt[depth - 1] >= 0))
+    {
+        chk->seen[chk->seenAt[depth - 1]].found    |= 1ull << entered->bit;
+    }
+    if (entered->requiredMask)
+    {
+        chk->seenAt[depth]      = pkvinSchemaSee(chk, path, depth, at);
+        if (chk->seenAt[depth] < 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Whether lhs >= rhs, comparing integers as signed; never for a NaN.
+static int pkvinSchemaAtLeast(const KVINValue* lhs, const KVINValue* rhs)
+{
+    if ((lhs->type == KVIN_VAL_INTEGER) && (rhs->type == KVIN_VAL_INTEGER))
+    {
+        return (long long)lhs->integer >= (long long)rhs->integer;
+    }
+    long double l           = (lhs->type == KVIN_VAL_INTEGER) ? (long double)(long long)lhs->integer : lhs->real;
+    long double r           = (rhs->type == KVIN_VAL_INTEGER) ? (long double)(long long)rhs->integer : rhs->real;
+    return l >= r;
+}
+
+static void pkvinSchemaValue(KVINSchemaCheck* chk, int node, const KVINValue* value, const char* at)
+{
+    if (node < 0)
+    {
+        return;
+    }
+    const KVINSchemaNode*   rule    = &chk->schema->nodes[node];
+    if (!(rule->types & (1 << value->type)))
+    {
+        pkvinSchemaReport(chk, KVIN_SCH_TYPE, node, value, at);
+    }
+    else
+    if (((value->type == KVIN_VAL_INTEGER) || (value->type == KVIN_VAL_REAL))
+     && (((rule->min.type != KVIN_VAL_NONE) && !pkvinSchemaAtLeast(value, &rule->min))
+      || ((rule->max.type != KVIN_VAL_NONE) && !pkvinSchemaAtLeast(&rule->max, value))))
+    {
+        pkvinSchemaReport(chk, KVIN_SCH_RANGE, node, value, at);
+    }
+}
+
+// Checks text starting at fst, whose paths are at most capacity deep, into
+// errs (which may be smaller than the number of errors found).
+int kvinInitSchemaCheck(KVINSchemaCheck* chk, const KVINSchema* schema, const char* fst, int capacity, KVINSchemaError* errs, int maxErrs)
+{
+    kvin_assert(chk);
+    kvin_assert(schema);
+    kvin_assert(fst);
+    kvin_assert(errs || !maxErrs);
+
+    KVINSchemaCheck empty   = { 0 };
+    int             capAt   = 0;
+    int             capSeen = 0;
+    *chk                    = empty;
+    chk->schema             = schema;
+    chk->capacity           = capacity;
+    chk->errs               = errs;
+    chk->maxErrs            = maxErrs;
+    chk->fst                = fst;
+    chk->lineAt             = fst;
+    chk->lineBeg            = fst;
+    chk->lineNo             = 1;
+    if (!pkvinGrow(schema->Realloc, schema->handle, (void**)&chk->nodeAt, &capAt, capacity + 1, sizeof(int))
+     || !pkvinGrow(schema->Realloc, schema->handle, (void**)&chk->seenAt, &capSeen, capacity + 1, sizeof(int))
+     || !pkvinGrowTable(schema->Realloc, schema->handle, &chk->seenTable, &chk->seenMask, pkvinSchemaSeenHash, chk))
+    {
+        kvinFreeSchemaCheck(chk);
+        return 0;
+    }
+    chk->nodeAt[0]          = 0;
+    chk->seenAt[0]          = schema->nodes[0].requiredMask ? pkvinSchemaSee(chk, 0, 0, 0) : -1;
+    if (schema->nodes[0].requiredMask && (chk->seenAt[0] < 0))
+    {
+        kvinFreeSchemaCheck(chk);
+        return 0;
+    }
+    return 1;
+}
+
+// Call after kvinPathApply, for each step of the parse. Returns 0 only if
+// memory or the path's capacity ran out.
+int kvinSchemaApply(KVINSchemaCheck* chk, const KVINPath* path, const KVINParser* prs)
+{
+    kvin_assert(chk);
+    kvin_assert(path);
+    kvin_assert(prs);
+
+    switch (prs->action)
+    {
+    case KVIN_ACT_SETATROOT     :
+    case KVIN_ACT_SETNEXTAXIS   :
+    case KVIN_ACT_AUTONUMBER    :
+        return pkvinSchemaEnter(chk, path, prs);
+    case KVIN_ACT_SETVALUE      :
+        if (path->depth > 0)
+        {
+            pkvinSchemaValue(chk, chk->nodeAt[path->depth], &prs->value, prs->lexer.lbeg);
+        }
+        return 1;
+    default                     :
+        return 1;
+    }
+}
+
+// The index of the lowest set bit of mask, which is not 0.
+static int pkvinLowBit(unsigned long long mask)
+{
+#ifdef  __GNUC__
+    return __builtin_ctzll(mask);
+#else// __GNUC__
+    int bit                 = 0;
+    for (; !(mask & 1); mask >>= 1)
+    {
+        ++bit;
+    }
+    return bit;
+#endif//__GNUC__
+}
+
+// Once the parse is done: reports required keys missing from where their
+// parent was seen, after the errors found on the way, and returns the number
+// of errors (including those there was no room for).
+int kvinSchemaFinish(KVINSchemaCheck* chk)
+{
+    kvin_assert(chk);
+
+    const KVINSchema*   schema  = chk->schema;
+    chk->lineAt                 = chk->fst;
+    chk->lineBeg                = chk->fst;
+    chk->lineNo                 = 1;
+    for (int SS = 0; SS < chk->numSeen; ++SS)
+    {
+        const KVINSchemaSeen*   seen    = &chk->seen[SS];
+        const KVINSchemaNode*   parent  = &schema->nodes[seen->node];
+        for (unsigned long long missing = parent->requiredMask & ~seen->found; missing; missing &= missing - 1)
+        {
+            pkvinSchemaReport(chk, KVIN_SCH_MISSING, schema->requiredChild[parent->requiredAt + pkvinLowBit(missing)], 0, seen->at);
+        }
+    }
+    return chk->numErrs;
+}
+
+void kvinFreeSchemaCheck(KVINSchemaCheck* chk)
+{
+    if (!chk || !chk->schema)
+    {
+        return;
+    }
+    void* blocks[]          = { chk->nodeAt, chk->seenAt, chk->seen, chk->seenTable, chk->keys };
+    for (int II = 0; II < (int)(sizeof(blocks) / sizeof(blocks[0])); ++II)
+    {
+        if (blocks[II])
+        {
+            chk->schema->Realloc(chk->schema->handle, blocks[II], 0);
+        }
+    }
+    chk->nodeAt             = 0;
+    chk->seenAt             = 0;
+    chk->seen               = 0;
+    chk->seenTable          = 0;
+    chk->keys               = 0;
+    chk->numSeen            = 0;
+}
+
+// Parses and checks [fst, lst) against schema in one pass, without building
+// anything: returns the number of errors, or -1 if out of memory. A syntax
+// error (or a path deeper than KVIN_SCHEMA_DEPTH) stops the check.
+int kvinSchemaValidate(const KVINSchema* schema, const char* fst, const char* lst, KVINSchemaError* errs, int maxErrs)
+{
+    kvin_assert(schema);
+    kvin_assert(fst);
+    kvin_assert(lst);
+
+    KVINSchemaCheck chk;
+    KVINParser      prs;
+    KVINPath        path;
+    int             numErrs = -1;
+    KVINValue      *axes    = (KVINValue*)schema->Realloc(schema->handle, 0, KVIN_SCHEMA_DEPTH * sizeof(KVINValue));
+    if (!axes)
+    {
+        return -1;
+    }
+    kvinInitPath(&path, axes, KVIN_SCHEMA_DEPTH);
+    if (kvinInitSchemaCheck(&chk, schema, fst, KVIN_SCHEMA_DEPTH, errs, maxErrs))
+    {
+        int     more        = 0;
+        int     applied     = 1;
+        prs.state           = KVIN_PAR_DONE;
+        if ((fst < lst) && kvinInitParser(&prs, fst, lst))
+        do
+        {
+            more            = kvinParseNext(&prs);
+            if (!kvinPathApply(&path, &prs))
+            {
+                pkvinSchemaReport(&chk, KVIN_SCH_DEPTH, -1, 0, prs.lexer.lbeg);
+                break;
+            }
+            applied         = kvinSchemaApply(&chk, &path, &prs);
+        }
+        while (more && applied);
+
+        if (prs.state == KVIN_PAR_ERROR)
+        {
+            pkvinSchemaReport(&chk, KVIN_SCH_SYNTAX, -1, 0, (prs.lexer.lbeg < lst) ? prs.lexer.lbeg : lst);
+        }
+        else
+        if (applied && (prs.state == KVIN_PAR_DONE))
+        {
+            kvinSchemaFinish(&chk);
+        }
+        numErrs             = applied ? chk.numErrs : -1;
+        kvinFreeSchemaCheck(&chk);
+    }
+    schema->Realloc(schema->handle, axes, 0);
+    return numErrs;
+}
+
 #ifdef  __cplusplus
 } // extern "C".
 #endif//__cplusplus
@@ -0,0 +1,195 @@
+// Tests for rekvin_constexpr.h: `make constexpr` builds this with -std=c++17,
+// which checks the static_asserts (among them, that the header's parse table
+// is rekvin.h's), then runs it to compare KVIN literals with
+// what kvinParseNext and kvinPathApply make of the same text. It also checks
+// that a malformed literal does not compile (REKVIN_CONSTEXPR_MALFORMED).
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rekvin_constexpr.h"
+#define REKVIN_C
+#include "rekvin.h"
+
+// kvinLiteralTable is kvinParseTable with each function replaced by its step.
+static constexpr KVINParse  sStepParse[]    =
+{
+    pkvinError, pkvinAbsPath, pkvinRelPath, pkvinPath, pkvinDot, pkvinAssign, pkvinValue, pkvinReset, pkvinDone,
+};
+
+static constexpr int literalTableMatches()
+{
+    for (int LL = 0; LL < KVIN_LEX_MAX; ++LL)
+    {
+        for (int PP = 0; PP < KVIN_PAR_MAX; ++PP)
+        {
+            if (sStepParse[kvinLiteralTable[LL][PP]] != kvinParseTable[LL][PP])
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static_assert(sizeof(sStepParse) / sizeof(sStepParse[0]) == KVIN_STEP_DONE + 1, "");
+static_assert(literalTableMatches(), "kvinLiteralTable differs from kvinParseTable");
+
+static constexpr auto   kDefaults   = KVIN_LITERAL(
+    "// Defaults.\n"
+    "server.host        = localhost\n"
+    "      .port        = 8080\n"
+    "      .timeout     = 2.5\n"
+    "      .banner      = \"hello, \\\"world\\\"\"\n"
+    "workers[0].name    = a\n"
+    "       ..#.name    = b\n"
+    "         .weight   = -0x10\n"
+    "limits[3]          = 0x1p-2\n"
+    "server.port        = 8081\n");
+
+static_assert(kDefaults.numEntries == 9, "");
+static_assert(kDefaults.maxDepth == 3, "");
+static_assert(kvinLiteralFind(kDefaults, "server.host")->text == "localhost", "");
+static_assert(kvinLiteralFind(kDefaults, "server.port")->integer == 8081, "");
+static_assert(kvinLiteralFind(kDefaults, "server.timeout")->type == KVIN_VAL_REAL, "");
+static_assert(kvinLiteralFind(kDefaults, "server.timeout")->real == 2.5L, "");
+static_assert(kvinLiteralFind(kDefaults, "server.banner")->text == "hello, \\\"world\\\"", "");
+static_assert(kvinLiteralFind(kDefaults, "workers.1.name")->text == "b", "");
+static_assert(kvinLiteralFind(kDefaults, "workers.1.weight")->integer == 0ull - 16, "");
+static_assert(kvinLiteralFind(kDefaults, "limits.3")->real == 0.25L, "");
+static_assert(kvinLiteralFind(kDefaults, "workers.1") == nullptr, "");
+static_assert(kvinLiteralFind(kDefaults, "server.port")->type == KVIN_VAL_INTEGER, "");
+static_assert(kDefaults.entries[4].lineNo == 6, "");
+
+static constexpr auto   kEmpty      = KVIN_LITERAL("");
+static_assert((kEmpty.numEntries == 0) && (kEmpty.error.lineNo == 0), "");
+
+static constexpr auto   kBadSize    = kvinLiteralSize("a = 1\nb..c = 2\n");
+static_assert((kBadSize.error.lineNo == 2) && (kBadSize.error.column == 3), "");
+static_assert((kBadSize.error.state == KVIN_PAR_DOT) && (kBadSize.error.lex == KVIN_LEX_DOT), "");
+
+#ifdef  REKVIN_CONSTEXPR_MALFORMED
+static constexpr auto   kMalformed  = KVIN_LITERAL("a = 1\nb = \n");
+#endif//REKVIN_CONSTEXPR_MALFORMED
+
+static const char*  sInputs[] =
+{
+    "foo = 10\n",
+    "foo.bar = 10\n   .baz = 12\n",
+    "foo.bar.baz = 1\n  ...quux = 2\n",
+    "a[0] = 1\n .# = 2\n .# = 3\n",
+    "a.#= 1\n",
+    "x.[7].y = 1\n   .. # .y = 2\n",
+    "[2] = root\n[3].a = 1\n",
+    "s = \"a\\\"b\"\n",
+    "s = \"unterminated\n",
+    "s = \"x\\",
+    "r = 1.5e3\nr = -inf\nr = 09\nr = 0x1.8p1\nr = 1e400\n",
+    "n = 18446744073709551616\nn = -1\nn = 017\n",
+    "n = 9223372036854775807\nn = 9223372036854775808\nn = -9223372036854775808\nn = -9223372036854775809\nn = -0\n",
+    "bad = 1x\n",
+    "// comment\n  // another\nk = v // trailing\n",
+    "a = / b\n",
+    "a = 1",
+    "a.b",
+    "a = 1\n\n\nb = \n",
+    "a.\"s\" = 1\n",
+    "a..b = 1\n",
+    ". = 1\n",
+    "[x] = 1\n",
+    "a[1 = 2\n",
+    "a = \"multi\nline\"\nb = 2\nc = ]\n",
+    "a.b.c = 1\n.....d = 2\n",
+};
+
+// The literal as the runtime parser sees it, as text, and the first error.
+static void describeRuntime(const char* kvin, char* buf, size_t size)
+{
+    KVINValue   axes[16];
+    KVINPath    path;
+    KVINParser  prs;
+    KVINError   err;
+    size_t      used        = 0;
+    int         more        = 0;
+    buf[0]                  = 0;
+    kvinInitPath(&path, axes, 16);
+    if (!kvinInitParser(&prs, kvin, kvin + strlen(kvin)))
+    {
+        prs.state           = KVIN_PAR_DONE;
+    }
+    else
+    do
+    {
+        more                = kvinParseNext(&prs);
+        kvinPathApply(&path, &prs);
+        if (prs.action != KVIN_ACT_SETVALUE)
+        {
+            continue;
+        }
+        for (int DD = 0; DD < path.depth; ++DD)
+        {
+            used   += (path.axes[DD].type == KVIN_VAL_INTEGER)
+                    ? snprintf(buf + used, size - used, "%llu/", path.axes[DD].integer)
+                    : snprintf(buf + used, size - used, "%.*s/", (int)(path.axes[DD].end - path.axes[DD].begin), path.axes[DD].begin);
+        }
+        switch (prs.value.type)
+        {
+        case KVIN_VAL_INTEGER   : used += snprintf(buf + used, size - used, "=%llu;", prs.value.integer);        break;
+        case KVIN_VAL_REAL      : used += snprintf(buf + used, size - used, "=%.17g;", (double)prs.value.real);  break;
+        default                 : used += snprintf(buf + used, size - used, "=%d:%.*s;", (int)prs.value.type, (int)(prs.value.end - prs.value.begin), prs.value.begin); break;
+        }
+    } while (more);
+    if ((prs.state != KVIN_PAR_DONE) && (kvinValidate(kvin, kvin + strlen(kvin), &err, 1) > 0))
+    {
+        snprintf(buf + used, size - used, "!%d:%d:%d:%d", err.lineNo, err.column, (int)err.state, (int)err.lex);
+    }
+}
+
+static void describeLiteral(const char* kvin, char* buf, size_t size)
+{
+    const KVINLiteral<64, 256>  lit     = kvinLiteralParse<64, 256, 16>(kvin);
+    size_t                      used    = 0;
+    buf[0]                              = 0;
+    for (int EE = 0; EE < lit.numEntries; ++EE)
+    {
+        const KVINLiteralEntry* entry   = &lit.entries[EE];
+        for (int DD = 0; DD < entry->depth; ++DD)
+        {
+            const KVINLiteralValue* axis    = &lit.axes[entry->axis + DD];
+            used   += (axis->type == KVIN_VAL_INTEGER)
+                    ? snprintf(buf + used, size - used, "%llu/", axis->integer)
+                    : snprintf(buf + used, size - used, "%.*s/", (int)axis->text.size(), axis->text.data());
+        }
+        switch (entry->value.type)
+        {
+        case KVIN_VAL_INTEGER   : used += snprintf(buf + used, size - used, "=%llu;", entry->value.integer);        break;
+        case KVIN_VAL_REAL      : used += snprintf(buf + used, size - used, "=%.17g;", (double)entry->value.real);  break;
+        default                 : used += snprintf(buf + used, size - used, "=%d:%.*s;", (int)entry->value.type, (int)entry->value.text.size(), entry->value.text.data()); break;
+        }
+    }
+    if (lit.error.lineNo)
+    {
+        snprintf(buf + used, size - used, "!%d:%d:%d:%d", lit.error.lineNo, lit.error.column, (int)lit.error.state, (int)lit.error.lex);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+    int     numFailed   = 0;
+    char    expected[1024];
+    char    actual[1024];
+    for (int EE = 0; EE < (int)(sizeof(sInputs) / sizeof(sInputs[0])); ++EE)
+    {
+        describeRuntime(sInputs[EE], expected, sizeof(expected));
+        describeLiteral(sInputs[EE], actual, sizeof(actual));
+        if (strcmp(expected, actual))
+        {
+            printf("literal %d failed:\n    runtime  %s\n    literal  %s\n", EE, expected, actual);
+            ++numFailed;
+        }
+    }
+    printf("constexpr %s: %d literals, %d failed\n", numFailed ? "FAILED" : "passed", (int)(sizeof(sInputs) / sizeof(sInputs[0])), numFailed);
+    return !!numFailed;
+}
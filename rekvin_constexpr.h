@@ -0,0 +1,671 @@
+#ifndef REKVIN_CONSTEXPR_H
+#define REKVIN_CONSTEXPR_H
+
+// Compile-time parsing of KVIN literals (C++17).
+//
+//      static constexpr auto kDefaults = KVIN_LITERAL(
+//          "server.host = localhost\n"
+//          "      .port = 8080\n");
+//      static_assert(kvinLiteralFind(kDefaults, "server.port")->integer == 8080, "");
+//
+// KVIN_LITERAL runs the lexer and the parse state machine of rekvin.h in a
+// constant expression, and yields a KVINLiteral: every assignment, in order,
+// with its resolved absolute path and typed value, all read-only data. A
+// malformed literal is a compile error, reported as an instantiation of
+// KVINLiteralMalformedAt<line, column>.
+//
+// The grammar is kvinParseTable's, step for step: kvinLiteralTable below is
+// that table with each function replaced by an enumerator, which
+// rekvin_constexpr.cpp checks at compile time. Reals are read as
+// the REKVIN_NO_STDLIB build reads them, in long double. Identifiers and
+// byte-strings are views into the literal, byte-strings still escaped (decode
+// them with kvinUnescape).
+//
+// Literals are parsed twice, once to size the result, and compilers bound
+// constant evaluation (gcc: -fconstexpr-ops-limit), so this is for defaults
+// of a few kilobytes, not for data.
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error rekvin_constexpr.h needs C++17.
+#endif
+
+#include <string_view>
+
+#include "rekvin.h"
+
+typedef struct KVINLiteralValue
+{
+    KVIN_VALUE          type        = KVIN_VAL_NONE;
+    unsigned long long  integer     = 0;
+    long double         real        = 0;
+    std::string_view    text        = {};   // IDENTIFIER and BSTRING.
+} KVINLiteralValue;
+
+typedef struct KVINLiteralEntry
+{
+    int                 axis        = 0;    // The path is axes[axis] to axes[axis + depth - 1].
+    int                 depth       = 0;
+    int                 lineNo      = 0;
+    KVINLiteralValue    value       = {};
+} KVINLiteralEntry;
+
+// numEntries and numAxes are the counts the literal needs, which may be more
+// than NumEntries and NumAxes: only the first ones fit are kept.
+template <int NumEntries, int NumAxes>
+struct KVINLiteral
+{
+    KVINLiteralEntry    entries[NumEntries > 0 ? NumEntries : 1]    = {};
+    KVINLiteralValue    axes[NumAxes > 0 ? NumAxes : 1]             = {};
+    int                 numEntries  = 0;
+    int                 numAxes     = 0;
+    int                 maxDepth    = 0;
+    KVINError           error       = {};   // lineNo is 0 unless malformed.
+};
+
+enum KVIN_LITERAL_STEP
+{
+    KVIN_STEP_ERROR,
+    KVIN_STEP_ABSPATH,
+    KVIN_STEP_RELPATH,
+    KVIN_STEP_PATH,
+    KVIN_STEP_DOT,
+    KVIN_STEP_ASSIGN,
+    KVIN_STEP_VALUE,
+    KVIN_STEP_RESET,
+    KVIN_STEP_DONE,
+};
+
+#define KVIN_S(X)   KVIN_STEP_ ## X
+
+constexpr unsigned char kvinLiteralTable[KVIN_LEX_MAX][KVIN_PAR_MAX] =
+{
+                        /*  ERROR           INITIAL         ABSPATH         RELPATH         DOT             PATH            ASSIGN          EOL             DONE            */
+    /* UNKNOWN    */    {   KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(DONE)    },
+    /* IDENTIFIER */    {   KVIN_S(ERROR),  KVIN_S(ABSPATH),KVIN_S(ERROR),  KVIN_S(PATH),   KVIN_S(PATH),   KVIN_S(ERROR),  KVIN_S(VALUE),  KVIN_S(ERROR),  KVIN_S(DONE)    },
+    /* NUMBERLIKE */    {   KVIN_S(ERROR),  KVIN_S(ABSPATH),KVIN_S(ERROR),  KVIN_S(PATH),   KVIN_S(PATH),   KVIN_S(ERROR),  KVIN_S(VALUE),  KVIN_S(ERROR),  KVIN_S(DONE)    },
+    /* DOT        */    {   KVIN_S(ERROR),  KVIN_S(RELPATH),KVIN_S(DOT),    KVIN_S(RELPATH),KVIN_S(ERROR),  KVIN_S(DOT),    KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(DONE)    },
+    /* HASH       */    {   KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(PATH),   KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(DONE)    },
+    /* EQUALS     */    {   KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ASSIGN), KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ASSIGN), KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(DONE)    },
+    /* BSTRING    */    {   KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(VALUE),  KVIN_S(ERROR),  KVIN_S(DONE)    },
+    /* LBRACKET   */    {   KVIN_S(ERROR),  KVIN_S(ABSPATH),KVIN_S(PATH),   KVIN_S(PATH),   KVIN_S(ERROR),  KVIN_S(PATH),   KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(DONE)    },
+    /* RBRACKET   */    {   KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(DONE)    },
+    /* EOL        */    {   KVIN_S(ERROR),  KVIN_S(RESET),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(ERROR),  KVIN_S(RESET),  KVIN_S(DONE)    },
+};
+
+#undef  KVIN_S
+
+constexpr int kvinLiteralIsSpace(const char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\v') || (c == '\f') || (c == '\r');
+}
+
+constexpr int kvinLiteralIsDigit(const char c)
+{
+    return (c >= '0') && (c <= '9');
+}
+
+constexpr int kvinLiteralIsXDigit(const char c)
+{
+    return kvinLiteralIsDigit(c) || (((c | 0x20) >= 'a') && ((c | 0x20) <= 'f'));
+}
+
+constexpr int kvinLiteralIsCid(const char c)
+{
+    return (((c | 0x20) >= 'a') && ((c | 0x20) <= 'z')) || (c == '_');
+}
+
+constexpr int kvinLiteralIsCidn(const char c)
+{
+    return kvinLiteralIsCid(c) || kvinLiteralIsDigit(c);
+}
+
+constexpr int kvinLiteralIsCidnd(const char c)
+{
+    return kvinLiteralIsCidn(c) || (c == '.') || (c == '-') || (c == '+');
+}
+
+constexpr int kvinLiteralDigitVal(const char c)
+{
+    return kvinLiteralIsDigit(c) ? (c - '0') : ((c | 0x20) - 'a' + 10);
+}
+
+// kvinLexNext.
+constexpr int kvinLiteralLexNext(KVINLexer* lex)
+{
+    lex->lbeg       = lex->lend;
+    if (lex->lend >= lex->end)
+    {
+        if (lex->lex != KVIN_LEX_UNKNOWN)
+        {
+            lex->lex    = KVIN_LEX_EOL;
+        }
+        return 0;
+    }
+
+    lex->lex        = KVIN_LEX_UNKNOWN;
+    int wsLike      = 0;
+
+    do
+    {
+        wsLike      = 0;
+        while ((lex->lend < lex->end) && kvinLiteralIsSpace(*lex->lend) && (lex->lend[0] != '\n'))
+        {
+            wsLike  = 1;
+            ++lex->lend;
+        }
+
+        if (lex->lend >= lex->end)
+        {
+            return 0;
+        }
+
+        if (lex->lend[0] == '/')
+        {
+            wsLike  = 0;
+            if (((lex->lend + 1) >= lex->end) || (lex->lend[1] != '/'))
+            {
+                lex->lbeg   = lex->lend;
+                return 1;
+            }
+            while ((lex->lend < lex->end) && (lex->lend[0] != '\n'))
+            {
+                ++lex->lend;
+            }
+        }
+    } while (wsLike);
+
+    if (lex->lend >= lex->end)
+    {
+        return 0;
+    }
+
+    lex->lbeg   = lex->lend;
+
+    switch (lex->lend[0])
+    {
+    case '\n'   : ++lex->lend;  lex->lex    = KVIN_LEX_EOL;         ++lex->lineNo;  return 1;
+    case '.'    : ++lex->lend;  lex->lex    = KVIN_LEX_DOT;         return 1;
+    case '='    : ++lex->lend;  lex->lex    = KVIN_LEX_EQUALS;      return 1;
+    case '#'    : ++lex->lend;  lex->lex    = KVIN_LEX_HASH;        return 1;
+    case '['    : ++lex->lend;  lex->lex    = KVIN_LEX_LBRACKET;    return 1;
+    case ']'    : ++lex->lend;  lex->lex    = KVIN_LEX_RBRACKET;    return 1;
+    case '"'    :
+        ++lex->lend;
+        while ((lex->lend < lex->end) && (lex->lend[0] != '"'))
+        {
+            lex->lend  += ((lex->lend[0] == '\\') && ((lex->lend + 1) < lex->end)) ? 2 : 1;
+            lex->lineNo    += (lex->lend[-1] == '\n');
+        }
+        if (lex->lend >= lex->end)
+        {
+            lex->lend   = lex->end;
+            return 1;
+        }
+        ++lex->lend;
+        lex->lex    = KVIN_LEX_BSTRING;
+        return 1;
+    default     : break;
+    }
+
+    if (kvinLiteralIsCid(*lex->lend))
+    {
+        while ((lex->lend < lex->end) && kvinLiteralIsCidn(*lex->lend))
+        {
+            ++lex->lend;
+        }
+        lex->lex    = KVIN_LEX_IDENTIFIER;
+        return 1;
+    }
+
+    if (kvinLiteralIsCidnd(*lex->lend))
+    {
+        while ((lex->lend < lex->end) && kvinLiteralIsCidnd(*lex->lend))
+        {
+            ++lex->lend;
+        }
+        lex->lex    = KVIN_LEX_NUMBERLIKE;
+        return 1;
+    }
+
+    return 1;
+}
+
+// kvin_strtoull: base 0, bounded by end; overflow reads nothing.
+constexpr unsigned long long kvinLiteralStrtoull(const char* beg, const char* end, const char** last)
+{
+    const char*         cur     = beg;
+    int                 neg     = 0;
+    int                 base    = 10;
+    int                 over    = 0;
+    unsigned long long  ull     = 0;
+
+    if ((cur < end) && ((*cur == '+') || (*cur == '-')))
+    {
+        neg                     = (*cur++ == '-');
+    }
+    if (((end - cur) > 2) && (cur[0] == '0') && ((cur[1] | 0x20) == 'x') && kvinLiteralIsXDigit(cur[2]))
+    {
+        base                    = 16;
+        cur                    += 2;
+    }
+    else
+    if ((cur < end) && (cur[0] == '0'))
+    {
+        base                    = 8;
+    }
+    const char*         digits  = cur;
+    for (; (cur < end) && ((base == 16) ? kvinLiteralIsXDigit(*cur) : (kvinLiteralIsDigit(*cur) && (*cur - '0' < base))); ++cur)
+    {
+        unsigned digit          = (unsigned)kvinLiteralDigitVal(*cur);
+        over                   |= (ull > (~0ull - digit) / base);
+        ull                     = ull * base + digit;
+    }
+    *last                       = ((cur == digits) || over) ? beg : cur;
+    if (over)
+    {
+        return ~0ull;
+    }
+    return neg ? (0ull - ull) : ull;
+}
+
+constexpr long double kvinLiteralPow(long double b, int e)
+{
+    long double result  = 1.0L;
+    for (; e; e >>= 1, b *= b)
+    {
+        if (e & 1)
+        {
+            result     *= b;
+        }
+    }
+    return result;
+}
+
+constexpr int kvinLiteralMatchNoCase(const char* beg, const char* end, const char* word)
+{
+    for (; *word; ++beg, ++word)
+    {
+        if ((beg >= end) || ((*beg | 0x20) != *word))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// kvin_strtold, as built with REKVIN_NO_STDLIB.
+constexpr long double kvinLiteralStrtold(const char* beg, const char* end, const char** last)
+{
+    const char*         cur     = beg;
+    int                 neg     = 0;
+    int                 digits  = 0;
+    int                 scale   = 0;
+    unsigned long long  mant    = 0;
+
+    *last                       = beg;
+    if ((cur < end) && ((*cur == '+') || (*cur == '-')))
+    {
+        neg                     = (*cur++ == '-');
+    }
+    if (kvinLiteralMatchNoCase(cur, end, "inf"))
+    {
+        *last                   = cur + (kvinLiteralMatchNoCase(cur, end, "infinity") ? 8 : 3);
+        return neg ? -__builtin_infl() : __builtin_infl();
+    }
+    if (kvinLiteralMatchNoCase(cur, end, "nan"))
+    {
+        *last                   = cur + 3;
+        return neg ? -__builtin_nanl("") : __builtin_nanl("");
+    }
+
+    int     hex                 = ((end - cur) > 1) && (cur[0] == '0') && ((cur[1] | 0x20) == 'x');
+    cur                        += hex ? 2 : 0;
+    int     base                = hex ? 16 : 10;
+    int     maxDigits           = hex ? 15 : 19;
+    int     seen                = 0;
+    for (int frac = 0; cur < end; ++cur)
+    {
+        if ((*cur == '.') && !frac)
+        {
+            frac                = 1;
+            continue;
+        }
+        if (!(hex ? kvinLiteralIsXDigit(*cur) : kvinLiteralIsDigit(*cur)))
+        {
+            break;
+        }
+        seen                    = 1;
+        if ((mant == 0) && (*cur == '0'))
+        {
+            scale              -= frac;
+            continue;
+        }
+        if (digits < maxDigits)
+        {
+            mant                = mant * base + (unsigned)kvinLiteralDigitVal(*cur);
+            scale              -= frac;
+            ++digits;
+        }
+        else
+        {
+            scale              += !frac;
+        }
+    }
+    if (!seen)
+    {
+        return 0;
+    }
+    *last                       = cur;
+
+    scale                      *= hex ? 4 : 1;
+    if ((cur < end) && ((*cur | 0x20) == (hex ? 'p' : 'e')))
+    {
+        const char* exp         = cur + 1;
+        int         expNeg      = 0;
+        int         expVal      = 0;
+        if ((exp < end) && ((*exp == '+') || (*exp == '-')))
+        {
+            expNeg              = (*exp++ == '-');
+        }
+        if ((exp < end) && kvinLiteralIsDigit(*exp))
+        {
+            for (; (exp < end) && kvinLiteralIsDigit(*exp); ++exp)
+            {
+                expVal          = (expVal < 100000) ? (10 * expVal + (*exp - '0')) : expVal;
+            }
+            *last               = exp;
+            scale              += expNeg ? -expVal : expVal;
+        }
+    }
+    long double b               = hex ? 2.0L : 10.0L;
+    long double ld              = (scale < 0) ? ((long double)mant / kvinLiteralPow(b, -scale)) : ((long double)mant * kvinLiteralPow(b, scale));
+    return neg ? -ld : ld;
+}
+
+// The parser and KVINPath state; path holds the first MaxDepth axes.
+template <int MaxDepth>
+struct KVINLiteralParser
+{
+    KVINLexer           lexer       = {};
+    KVIN_PARSES         state       = KVIN_PAR_INITIAL;
+    KVINLiteralValue    path[MaxDepth > 0 ? MaxDepth : 1]   = {};
+    int                 depth       = 0;
+    KVINLiteralValue    popped      = {};
+    int                 lineNo      = 1;
+    const char*         lineAt      = nullptr;  // lineNo is the line of lineAt.
+    const char*         lineBeg     = nullptr;
+};
+
+template <int MaxDepth>
+constexpr void kvinLiteralLocate(KVINLiteralParser<MaxDepth>* prs, const char* at)
+{
+    for (; prs->lineAt < at; ++prs->lineAt)
+    {
+        if (*prs->lineAt == '\n')
+        {
+            ++prs->lineNo;
+            prs->lineBeg    = prs->lineAt + 1;
+        }
+    }
+}
+
+// A step of kvinParseNext, then of kvinPathApply. Stops at the first error.
+template <int NumEntries, int NumAxes, int MaxDepth>
+constexpr int kvinLiteralParseNext(KVINLiteral<NumEntries, NumAxes>* lit, KVINLiteralParser<MaxDepth>* prs)
+{
+    KVINLexer*          lex     = &prs->lexer;
+    KVIN_PARSES         before  = prs->state;
+    KVIN_ACTION         action  = KVIN_ACT_NONE;
+    KVINLiteralValue    value   = {};
+    const char*         last    = nullptr;
+
+    if (!kvinLiteralLexNext(lex))
+    {
+        if ((prs->state == KVIN_PAR_INITIAL) || (prs->state == KVIN_PAR_EOL))
+        {
+            prs->state          = KVIN_PAR_DONE;
+            return 0;
+        }
+        prs->state              = KVIN_PAR_ERROR;
+    }
+    else
+    {
+        const int   step        = kvinLiteralTable[lex->lex][prs->state];
+        switch (step)
+        {
+        case KVIN_STEP_ABSPATH  :
+        case KVIN_STEP_PATH     :
+            prs->state          = (step == KVIN_STEP_ABSPATH) ? KVIN_PAR_ABSPATH   : KVIN_PAR_PATH;
+            action              = (step == KVIN_STEP_ABSPATH) ? KVIN_ACT_SETATROOT : KVIN_ACT_SETNEXTAXIS;
+            // pkvinCommonPath.
+            if (lex->lex == KVIN_LEX_LBRACKET)
+            {
+                if (!kvinLiteralLexNext(lex) || (lex->lex != KVIN_LEX_NUMBERLIKE))
+                {
+                    prs->state  = KVIN_PAR_ERROR;
+                    break;
+                }
+                value.type      = KVIN_VAL_INTEGER;
+                value.integer   = kvinLiteralStrtoull(lex->lbeg, lex->lend, &last);
+                if (!kvinLiteralLexNext(lex) || (lex->lex != KVIN_LEX_RBRACKET))
+                {
+                    prs->state  = KVIN_PAR_ERROR;
+                }
+            }
+            else
+            if (lex->lex == KVIN_LEX_HASH)
+            {
+                action          = KVIN_ACT_AUTONUMBER;
+            }
+            else
+            if (lex->lex == KVIN_LEX_IDENTIFIER)
+            {
+                value.type      = KVIN_VAL_IDENTIFIER;
+                value.text      = std::string_view(lex->lbeg, lex->lend - lex->lbeg);
+            }
+            else
+            {
+                value.type      = KVIN_VAL_INTEGER;
+                value.integer   = kvinLiteralStrtoull(lex->lbeg, lex->lend, &last);
+            }
+            break;
+        case KVIN_STEP_RELPATH  :
+            prs->state          = KVIN_PAR_RELPATH;
+            action              = KVIN_ACT_RELPATH;
+            break;
+        case KVIN_STEP_DOT      :
+            prs->state          = KVIN_PAR_DOT;
+            break;
+        case KVIN_STEP_ASSIGN   :
+            prs->state          = KVIN_PAR_ASSIGN;
+            break;
+        case KVIN_STEP_VALUE    :
+            prs->state          = KVIN_PAR_EOL;
+            action              = KVIN_ACT_SETVALUE;
+            if (lex->lex == KVIN_LEX_IDENTIFIER)
+            {
+                value.type      = KVIN_VAL_IDENTIFIER;
+                value.text      = std::string_view(lex->lbeg, lex->lend - lex->lbeg);
+            }
+            else
+            if (lex->lex == KVIN_LEX_BSTRING)
+            {
+                value.type      = KVIN_VAL_BSTRING;
+                value.text      = std::string_view(lex->lbeg + 1, lex->lend - lex->lbeg - 2);
+            }
+            else
+            {
+                // pkvinAnalyzeNumberLike.
+                value.type      = KVIN_VAL_INTEGER;
+                value.integer   = kvinLiteralStrtoull(lex->lbeg, lex->lend, &last);
+                if ((last != lex->lend) || ((value.integer != 0) && ((value.integer >> 63) != (unsigned long long)(*lex->lbeg == '-'))))
+                {
+                    value.integer   = 0;
+                    value.real      = kvinLiteralStrtold(lex->lbeg, lex->lend, &last);
+                    value.type      = (last == lex->lend) ? KVIN_VAL_REAL : KVIN_VAL_NONE;
+                }
+                if (value.type == KVIN_VAL_NONE)
+                {
+                    prs->state  = KVIN_PAR_ERROR;
+                }
+            }
+            break;
+        case KVIN_STEP_RESET    :
+            prs->state          = KVIN_PAR_INITIAL;
+            break;
+        case KVIN_STEP_DONE     :
+            prs->state          = KVIN_PAR_DONE;
+            return 0;
+        default                 :
+            prs->state          = KVIN_PAR_ERROR;
+            break;
+        }
+    }
+
+    if (prs->state == KVIN_PAR_ERROR)
+    {
+        // As kvinValidate reports it.
+        lit->error.at           = (lex->lbeg < lex->end) ? lex->lbeg : lex->end;
+        lit->error.state        = before;
+        lit->error.lex          = lex->lex;
+        kvinLiteralLocate(prs, lit->error.at);
+        lit->error.lineNo       = prs->lineNo;
+        lit->error.column       = (int)(lit->error.at - prs->lineBeg) + 1;
+        return 0;
+    }
+
+    switch (action)
+    {
+    case KVIN_ACT_SETATROOT     :
+        prs->depth              = 0;
+        [[fallthrough]];
+    case KVIN_ACT_SETNEXTAXIS   :
+        if (prs->depth < MaxDepth)
+        {
+            prs->path[prs->depth]   = value;
+        }
+        ++prs->depth;
+        break;
+    case KVIN_ACT_RELPATH       :
+        if (prs->depth > 0)
+        {
+            --prs->depth;
+            prs->popped         = (prs->depth < MaxDepth) ? prs->path[prs->depth] : KVINLiteralValue{};
+        }
+        break;
+    case KVIN_ACT_AUTONUMBER    :
+        if (prs->depth < MaxDepth)
+        {
+            prs->path[prs->depth]           = KVINLiteralValue{};
+            prs->path[prs->depth].type      = KVIN_VAL_INTEGER;
+            prs->path[prs->depth].integer   = (prs->popped.type == KVIN_VAL_INTEGER) ? prs->popped.integer + 1 : 0;
+        }
+        ++prs->depth;
+        break;
+    case KVIN_ACT_SETVALUE      :
+        if ((lit->numEntries < NumEntries) && (lit->numAxes + prs->depth <= NumAxes) && (prs->depth <= MaxDepth))
+        {
+            KVINLiteralEntry*   entry   = &lit->entries[lit->numEntries];
+            kvinLiteralLocate(prs, lex->lbeg);
+            entry->axis         = lit->numAxes;
+            entry->depth        = prs->depth;
+            entry->lineNo       = prs->lineNo;
+            entry->value        = value;
+            for (int DD = 0; DD < prs->depth; ++DD)
+            {
+                lit->axes[lit->numAxes + DD]    = prs->path[DD];
+            }
+        }
+        ++lit->numEntries;
+        lit->numAxes           += prs->depth;
+        lit->maxDepth           = (prs->depth > lit->maxDepth) ? prs->depth : lit->maxDepth;
+        break;
+    default                     :
+        break;
+    }
+    return 1;
+}
+
+template <int NumEntries, int NumAxes, int MaxDepth>
+constexpr KVINLiteral<NumEntries, NumAxes> kvinLiteralParse(std::string_view kvin)
+{
+    KVINLiteral<NumEntries, NumAxes>    lit = {};
+    KVINLiteralParser<MaxDepth>         prs = {};
+    prs.lexer.lex               = KVIN_LEX_UNKNOWN;
+    prs.lexer.begin             = kvin.data();
+    prs.lexer.lbeg              = kvin.data();
+    prs.lexer.lend              = kvin.data();
+    prs.lexer.end               = kvin.data() + kvin.size();
+    prs.lineAt                  = kvin.data();
+    prs.lineBeg                 = kvin.data();
+    while (kvinLiteralParseNext(&lit, &prs))
+    {
+    }
+    return lit;
+}
+
+// The sizes a literal needs: the counts from parsing it with no storage.
+constexpr KVINLiteral<0, 0> kvinLiteralSize(std::string_view kvin)
+{
+    return kvinLiteralParse<0, 0, 0>(kvin);
+}
+
+template <int LineNo, int Column>
+struct KVINLiteralMalformedAt
+{
+    static_assert(LineNo == 0, "malformed KVIN literal, at the line and column of this KVINLiteralMalformedAt<>");
+    static constexpr int ok = 1;
+};
+
+#define KVIN_LITERAL(STR)                                                                       \
+    ([]() constexpr                                                                             \
+    {                                                                                           \
+        constexpr auto  kvinSize    = kvinLiteralSize(STR);                                     \
+        constexpr auto  kvinLit     = kvinLiteralParse<kvinSize.numEntries, kvinSize.numAxes,   \
+                                                       kvinSize.maxDepth>(STR);                 \
+        static_assert(KVINLiteralMalformedAt<kvinLit.error.lineNo, kvinLit.error.column>::ok, ""); \
+        return kvinLit;                                                                         \
+    }())
+
+// The value last assigned to a path, or nullptr. The path is written as axes
+// joined by '.', where an axis of decimal digits is an integer: "servers.0.port".
+template <int NumEntries, int NumAxes>
+constexpr const KVINLiteralValue* kvinLiteralFind(const KVINLiteral<NumEntries, NumAxes>& lit, std::string_view path)
+{
+    const KVINLiteralValue*     found   = nullptr;
+    for (int EE = 0; (EE < lit.numEntries) && (EE < NumEntries); ++EE)
+    {
+        const KVINLiteralEntry* entry   = &lit.entries[EE];
+        size_t                  pos     = 0;
+        int                     DD      = 0;
+        for (; DD < entry->depth; ++DD)
+        {
+            size_t              dot     = path.find('.', pos);
+            if (pos > path.size())
+            {
+                break;
+            }
+            std::string_view    name    = path.substr(pos, (dot == std::string_view::npos) ? std::string_view::npos : (dot - pos));
+            const KVINLiteralValue* axis    = &lit.axes[entry->axis + DD];
+            int                 numeric = !name.empty();
+            unsigned long long  index   = 0;
+            for (char c : name)
+            {
+                numeric        &= kvinLiteralIsDigit(c);
+                index           = index * 10 + (unsigned)(c - '0');
+            }
+            if ((axis->type == KVIN_VAL_INTEGER) ? !(numeric && (axis->integer == index)) : (axis->text != name))
+            {
+                break;
+            }
+            pos                 = (dot == std::string_view::npos) ? (path.size() + 1) : (dot + 1);
+        }
+        if ((DD == entry->depth) && (pos == path.size() + 1))
+        {
+            found               = &entry->value;
+        }
+    }
+    return found;
+}
+
+#endif//REKVIN_CONSTEXPR_H